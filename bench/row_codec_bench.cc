@@ -0,0 +1,184 @@
+//
+//  row_codec_bench.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+//  Micro-benchmark of the shared row codec against the row code the bindings
+//  carried before it (copying length-prefixed decode, linear filter).
+//
+//  Usage: row_codec_bench [fieldcount] [fieldlength] [iterations]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "core/db.h"
+#include "core/row_codec.h"
+
+using ycsbc::DB;
+using ycsbc::RowCodec;
+
+namespace {
+
+void BaselineSerialize(const std::vector<DB::Field> &values, std::string &data) {
+  for (const DB::Field &field : values) {
+    uint32_t len = field.name.size();
+    data.append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
+    data.append(field.name.data(), field.name.size());
+    len = field.value.size();
+    data.append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
+    data.append(field.value.data(), field.value.size());
+  }
+}
+
+void BaselineDeserialize(std::vector<DB::Field> &values, const std::string &data) {
+  const char *p = data.data();
+  const char *lim = p + data.size();
+  while (p != lim) {
+    uint32_t len;
+    memcpy(&len, p, sizeof(len));
+    p += sizeof(uint32_t);
+    std::string field(p, static_cast<const size_t>(len));
+    p += len;
+    memcpy(&len, p, sizeof(len));
+    p += sizeof(uint32_t);
+    std::string value(p, static_cast<const size_t>(len));
+    p += len;
+    values.push_back({field, value});
+  }
+}
+
+void BaselineDeserializeFilter(std::vector<DB::Field> &values, const std::string &data,
+                               const std::vector<std::string> &fields) {
+  const char *p = data.data();
+  const char *lim = p + data.size();
+  std::vector<std::string>::const_iterator filter_iter = fields.begin();
+  while (p != lim && filter_iter != fields.end()) {
+    uint32_t len;
+    memcpy(&len, p, sizeof(len));
+    p += sizeof(uint32_t);
+    std::string field(p, static_cast<const size_t>(len));
+    p += len;
+    memcpy(&len, p, sizeof(len));
+    p += sizeof(uint32_t);
+    std::string value(p, static_cast<const size_t>(len));
+    p += len;
+    if (*filter_iter == field) {
+      values.push_back({field, value});
+      filter_iter++;
+    }
+  }
+}
+
+// Keeps the optimizer from discarding the decoded output.
+size_t sink = 0;
+
+void Run(const char *name, size_t iterations, const std::function<void()> &op) {
+  for (size_t i = 0; i < iterations / 10; i++) {
+    op();
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    op();
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  printf("%-44s %10.1f ns/op\n", name, ns / iterations);
+}
+
+} // anonymous
+
+int main(int argc, const char *argv[]) {
+  const size_t field_count = argc > 1 ? std::stoul(argv[1]) : 10;
+  const size_t field_len = argc > 2 ? std::stoul(argv[2]) : 100;
+  const size_t iterations = argc > 3 ? std::stoul(argv[3]) : 1000000;
+  const std::string prefix = "field";
+
+  std::vector<DB::Field> row;
+  for (size_t i = 0; i < field_count; i++) {
+    row.push_back({prefix + std::to_string(i), std::string(field_len, 'a' + i % 26)});
+  }
+  // the read path of workloads with readallfields=false asks for the last field
+  const std::vector<std::string> last_field = {row.back().name};
+  std::vector<std::string> some_fields;
+  for (size_t i = 1; i < field_count; i += 3) {
+    some_fields.push_back(row[i].name);
+  }
+  const size_t slot = 2 * sizeof(uint32_t) + row[0].name.size() + field_len;
+
+  printf("fields %zu x %zu bytes, %zu iterations\n", field_count, field_len, iterations);
+
+  std::string baseline_data;
+  BaselineSerialize(row, baseline_data);
+  Run("baseline encode", iterations, [&] {
+    std::string data;
+    BaselineSerialize(row, data);
+    sink += data.size();
+  });
+  Run("baseline decode", iterations, [&] {
+    std::vector<DB::Field> values;
+    BaselineDeserialize(values, baseline_data);
+    sink += values.size();
+  });
+  Run("baseline project last field", iterations, [&] {
+    std::vector<DB::Field> values;
+    BaselineDeserializeFilter(values, baseline_data, last_field);
+    sink += values.size();
+  });
+  Run("baseline project every third field", iterations, [&] {
+    std::vector<DB::Field> values;
+    BaselineDeserializeFilter(values, baseline_data, some_fields);
+    sink += values.size();
+  });
+
+  const struct {
+    const char *name;
+    RowCodec codec;
+  } codecs[] = {
+    {"lengthprefixed", RowCodec(RowCodec::kLengthPrefixed, prefix, slot)},
+    {"indexed", RowCodec(RowCodec::kOffsetIndexed, prefix, slot)},
+    {"fixedslot", RowCodec(RowCodec::kFixedSlot, prefix, slot)},
+  };
+  for (const auto &c : codecs) {
+    std::string data;
+    c.codec.Encode(row, &data);
+    const std::string label = c.name;
+    Run((label + " encode").c_str(), iterations, [&] {
+      std::string out;
+      c.codec.Encode(row, &out);
+      sink += out.size();
+    });
+    Run((label + " decode").c_str(), iterations, [&] {
+      std::vector<DB::Field> values;
+      c.codec.Decode(data, &values);
+      sink += values.size();
+    });
+    Run((label + " decode view").c_str(), iterations, [&] {
+      std::vector<DB::FieldView> values;
+      c.codec.Decode(data, &values);
+      sink += values.size();
+    });
+    Run((label + " project last field").c_str(), iterations, [&] {
+      std::vector<DB::Field> values;
+      c.codec.DecodeFilter(data, last_field, &values);
+      sink += values.size();
+    });
+    Run((label + " project every third field").c_str(), iterations, [&] {
+      std::vector<DB::Field> values;
+      c.codec.DecodeFilter(data, some_fields, &values);
+      sink += values.size();
+    });
+    Run((label + " project every third field view").c_str(), iterations, [&] {
+      std::vector<DB::FieldView> values;
+      c.codec.DecodeFilter(data, some_fields, &values);
+      sink += values.size();
+    });
+  }
+  return sink == 0;
+}
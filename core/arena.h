@@ -0,0 +1,83 @@
+//
+//  arena.h
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#ifndef YCSB_C_ARENA_H_
+#define YCSB_C_ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace ycsbc {
+
+///
+/// Bump allocator backing the views returned by the zero-copy DB calls.
+/// Reset() recycles the memory; after a burst that needed several blocks the
+/// next Reset() replaces them by one block of the combined size, so a thread
+/// settles on a single allocation sized for its largest operation.
+///
+class Arena {
+ public:
+  explicit Arena(size_t block_size = 4096) : block_size_(block_size) {}
+
+  char *Allocate(size_t bytes) {
+    if (bytes > remaining_) {
+      NewBlock(std::max(bytes, block_size_));
+    }
+    char *p = ptr_;
+    ptr_ += bytes;
+    remaining_ -= bytes;
+    return p;
+  }
+
+  std::string_view Copy(const char *data, size_t len) {
+    char *p = Allocate(len);
+    memcpy(p, data, len);
+    return std::string_view(p, len);
+  }
+
+  std::string_view Copy(std::string_view s) {
+    return Copy(s.data(), s.size());
+  }
+
+  void Reset() {
+    if (blocks_.size() > 1) {
+      size_t total = total_;
+      blocks_.clear();
+      total_ = 0;
+      NewBlock(total);
+      return;
+    }
+    if (!blocks_.empty()) {
+      ptr_ = blocks_[0].get();
+      remaining_ = total_;
+    }
+  }
+
+  size_t MemoryUsage() const { return total_; }
+
+ private:
+  void NewBlock(size_t bytes) {
+    blocks_.emplace_back(new char[bytes]);
+    ptr_ = blocks_.back().get();
+    remaining_ = bytes;
+    total_ += bytes;
+  }
+
+  size_t block_size_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char *ptr_ = nullptr;
+  size_t remaining_ = 0;
+  size_t total_ = 0;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ARENA_H_
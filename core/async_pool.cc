@@ -0,0 +1,87 @@
+//
+//  async_pool.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#include "async_pool.h"
+
+#include <algorithm>
+
+namespace ycsbc {
+
+int AsyncPool::threads_ = 0;
+
+AsyncPool &AsyncPool::Shared() {
+  // hardware_concurrency() is 0 when unknown, and a pool without workers never completes
+  static AsyncPool pool(threads_ > 0 ? threads_
+                                     : std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+AsyncPool::AsyncPool(int threads) : stop_(false) {
+  for (int i = 0; i < threads; i++) {
+    workers_.emplace_back(&AsyncPool::Work, this);
+  }
+}
+
+AsyncPool::~AsyncPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+void AsyncPool::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void AsyncPool::Work() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void CompletionQueue::Push(std::function<void()> completion) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    ready_.push_back(std::move(completion));
+  }
+  cv_.notify_one();
+}
+
+int CompletionQueue::Drain(int min_completions) {
+  std::vector<std::function<void()>> ready;
+  {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this, min_completions] {
+      return static_cast<int>(ready_.size()) >= min_completions;
+    });
+    ready.swap(ready_);
+  }
+  for (std::function<void()> &completion : ready) {
+    completion();
+  }
+  return ready.size();
+}
+
+} // ycsbc
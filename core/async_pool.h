@@ -0,0 +1,72 @@
+//
+//  async_pool.h
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#ifndef YCSB_C_ASYNC_POOL_H_
+#define YCSB_C_ASYNC_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ycsbc {
+
+///
+/// Worker threads shared by every DB instance, running the synchronous calls
+/// behind the default asynchronous interface of bindings without a native one.
+///
+class AsyncPool {
+ public:
+  ///
+  /// The pool, started on first use with SetThreads threads, or one per
+  /// hardware thread if SetThreads was not called.
+  ///
+  static AsyncPool &Shared();
+  static void SetThreads(int threads) { threads_ = threads; }
+
+  void Submit(std::function<void()> task);
+
+  ~AsyncPool();
+
+ private:
+  explicit AsyncPool(int threads);
+  void Work();
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::vector<std::thread> workers_;
+  bool stop_;
+
+  static int threads_;
+};
+
+///
+/// Completions of the async ops of one DB instance. Whichever thread finishes
+/// an op queues its completion; the submitting thread runs it from Poll.
+///
+class CompletionQueue {
+ public:
+  void Push(std::function<void()> completion);
+  ///
+  /// Runs the queued completions, first waiting until at least
+  /// min_completions are queued.
+  /// @return The number of completions run.
+  ///
+  int Drain(int min_completions);
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<std::function<void()>> ready_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ASYNC_POOL_H_
@@ -9,33 +9,60 @@
 #ifndef YCSB_C_CLIENT_H_
 #define YCSB_C_CLIENT_H_
 
+#include <iostream>
 #include <string>
 #include "db.h"
+#include "db_factory.h"
+#include "db_wrapper.h"
+#include "flight_recorder.h"
 #include "core_workload.h"
+#include "core_workload_impl.h"
 #include "utils.h"
 #include "countdown_latch.h"
+#include "stage_breakdown.h"
 
 namespace ycsbc {
 
-inline int ClientThread(ycsbc::DB *db, ycsbc::CoreWorkload *wl, const int num_ops, bool is_loading,
-                        bool init_db, bool cleanup_db, CountDownLatch *latch) {
+///
+/// Runs num_ops operations of wl against db, which must be an Engine. With a
+/// final Engine the workload, measurement and binding calls are all direct.
+///
+template <class Workload, class Engine>
+int ClientThread(DB *db, CoreWorkload *workload, const int num_ops, bool is_loading,
+                 bool init_db, bool cleanup_db, CountDownLatch *latch) {
+    Engine *engine = static_cast<Engine *>(db);
+    Workload *wl = static_cast<Workload *>(workload);
     try {
         if (init_db) {
-            db->Init();
+            engine->Init();
         }
 
         int ops = 0;
+        const int async_depth = is_loading ? 0 : wl->async_depth();
+        int in_flight = 0;
         for (int i = 0; i < num_ops; ++i) {
             if (is_loading) {
-                wl->DoInsert(*db);
+                wl->DoInsert(*engine);
+            } else if (async_depth > 0) {
+                while (in_flight >= async_depth) {
+                    in_flight -= engine->Poll(1);
+                }
+                wl->DoTransactionAsync(*engine, &in_flight);
             } else {
-                wl->DoTransaction(*db);
+                wl->DoTransaction(*engine);
             }
             ops++;
         }
+        while (in_flight > 0) {
+            in_flight -= engine->Poll(1);
+        }
 
         if (cleanup_db) {
-            db->Cleanup();
+            engine->Cleanup();
+        }
+
+        if (StageBreakdown::Enabled()) {
+            StageBreakdown::FlushThread();
         }
 
         latch->CountDown();
@@ -46,6 +73,24 @@ inline int ClientThread(ycsbc::DB *db, ycsbc::CoreWorkload *wl, const int num_op
     }
 }
 
+template <class Engine>
+DB *NewStaticDB(utils::Properties *props, Measurements *measurements) {
+  Engine *db = new Engine;
+  db->SetProps(props);
+  return new DBWrapper<Engine>(db, measurements, FlightRecorder::Create(*props));
+}
+
+///
+/// Registers a client thread specialized for Engine, a final binding class
+/// compiled for one format, used for db_name whenever matcher accepts the run.
+/// Call from the binding's translation unit so the engine calls can inline.
+///
+template <class Engine>
+bool RegisterStaticDB(const std::string &db_name, DBFactory::FormatMatcher matcher) {
+  return DBFactory::RegisterClient(db_name, matcher, NewStaticDB<Engine>,
+                                   ClientThread<CoreWorkload, DBWrapper<Engine>>);
+}
+
 } // ycsbc
 
 #endif // YCSB_C_CLIENT_H_
@@ -14,9 +14,18 @@
 #include "skewed_latest_generator.h"
 #include "const_generator.h"
 #include "core_workload.h"
+#include "core_workload_impl.h"
 #include "random_byte_generator.h"
+#include "measurements.h"
+#include "timer.h"
+#include "async_pool.h"
 
 #include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <queue>
 #include <random>
 #include <string>
 
@@ -30,17 +39,33 @@ const char *ycsbc::kOperationString[ycsbc::MAXOPTYPE] = {
   "SCAN",
   "READMODIFYWRITE",
   "DELETE",
+  "REVERSE-SCAN",
+  "RANGE-SCAN",
   "INSERT-FAILED",
   "READ-FAILED",
   "UPDATE-FAILED",
   "SCAN-FAILED",
   "READMODIFYWRITE-FAILED",
-  "DELETE-FAILED"
+  "DELETE-FAILED",
+  "REVERSE-SCAN-FAILED",
+  "RANGE-SCAN-FAILED",
+  "VERIFY",
+  "VERIFY-STALE",
+  "VERIFY-CORRUPT"
 };
 
 const string CoreWorkload::TABLENAME_PROPERTY = "table";
 const string CoreWorkload::TABLENAME_DEFAULT = "usertable";
 
+const string CoreWorkload::TABLE_COUNT_PROPERTY = "tablecount";
+const string CoreWorkload::TABLE_COUNT_DEFAULT = "1";
+
+const string CoreWorkload::TABLE_DISTRIBUTION_PROPERTY = "tabledistribution";
+const string CoreWorkload::TABLE_DISTRIBUTION_DEFAULT = "uniform";
+
+const string CoreWorkload::TABLE_ZIPFIAN_CONST_PROPERTY = "tablezipfianconstant";
+const string CoreWorkload::TABLE_ZIPFIAN_CONST_DEFAULT = "0.99";
+
 const string CoreWorkload::FIELD_COUNT_PROPERTY = "fieldcount";
 const string CoreWorkload::FIELD_COUNT_DEFAULT = "10";
 
@@ -50,6 +75,9 @@ const string CoreWorkload::FIELD_LENGTH_DISTRIBUTION_DEFAULT = "constant";
 const string CoreWorkload::FIXED_KEY_8B = "fixedkey8b";
 const string CoreWorkload::FIXED_KEY_8B_DEFAULT = "false";
 
+const string CoreWorkload::KEY_ENCODING_PROPERTY = "keyencoding";
+const string CoreWorkload::KEY_ENCODING_DEFAULT = "decimal";
+
 const string CoreWorkload::FIXED_FIELD_LEN = "fixedfieldlen";
 const string CoreWorkload::FIXED_FIELD_LEN_DEFAULT = "false";
 
@@ -74,6 +102,12 @@ const string CoreWorkload::INSERT_PROPORTION_DEFAULT = "0.0";
 const string CoreWorkload::SCAN_PROPORTION_PROPERTY = "scanproportion";
 const string CoreWorkload::SCAN_PROPORTION_DEFAULT = "0.0";
 
+const string CoreWorkload::REVERSE_SCAN_PROPORTION_PROPERTY = "reversescanproportion";
+const string CoreWorkload::REVERSE_SCAN_PROPORTION_DEFAULT = "0.0";
+
+const string CoreWorkload::RANGE_SCAN_PROPORTION_PROPERTY = "rangescanproportion";
+const string CoreWorkload::RANGE_SCAN_PROPORTION_DEFAULT = "0.0";
+
 const string CoreWorkload::READMODIFYWRITE_PROPORTION_PROPERTY = "readmodifywriteproportion";
 const string CoreWorkload::READMODIFYWRITE_PROPORTION_DEFAULT = "0.0";
 
@@ -92,6 +126,15 @@ const string CoreWorkload::MAX_SCAN_LENGTH_DEFAULT = "1000";
 const string CoreWorkload::SCAN_LENGTH_DISTRIBUTION_PROPERTY = "scanlengthdistribution";
 const string CoreWorkload::SCAN_LENGTH_DISTRIBUTION_DEFAULT = "uniform";
 
+const string CoreWorkload::MIN_RANGE_LENGTH_PROPERTY = "minrangelength";
+const string CoreWorkload::MIN_RANGE_LENGTH_DEFAULT = "1";
+
+const string CoreWorkload::MAX_RANGE_LENGTH_PROPERTY = "maxrangelength";
+const string CoreWorkload::MAX_RANGE_LENGTH_DEFAULT = "1000";
+
+const string CoreWorkload::RANGE_LENGTH_DISTRIBUTION_PROPERTY = "rangelengthdistribution";
+const string CoreWorkload::RANGE_LENGTH_DISTRIBUTION_DEFAULT = "uniform";
+
 const string CoreWorkload::INSERT_ORDER_PROPERTY = "insertorder";
 const string CoreWorkload::INSERT_ORDER_DEFAULT = "hashed";
 
@@ -101,16 +144,213 @@ const string CoreWorkload::INSERT_START_DEFAULT = "0";
 const string CoreWorkload::RECORD_COUNT_PROPERTY = "recordcount";
 const string CoreWorkload::OPERATION_COUNT_PROPERTY = "operationcount";
 
+const string CoreWorkload::LOAD_MODE_PROPERTY = "loadmode";
+const string CoreWorkload::LOAD_MODE_DEFAULT = "insert";
+
 const std::string CoreWorkload::FIELD_NAME_PREFIX = "fieldnameprefix";
 const std::string CoreWorkload::FIELD_NAME_PREFIX_DEFAULT = "field";
 
+const string CoreWorkload::DATA_INTEGRITY_PROPERTY = "dataintegrity";
+const string CoreWorkload::DATA_INTEGRITY_DEFAULT = "false";
+
+const string CoreWorkload::ZERO_COPY_PROPERTY = "zerocopy";
+const string CoreWorkload::ZERO_COPY_DEFAULT = "false";
+
+const string CoreWorkload::STREAMING_SCAN_PROPERTY = "streamingscan";
+const string CoreWorkload::STREAMING_SCAN_DEFAULT = "false";
+
+const string CoreWorkload::ASYNC_DEPTH_PROPERTY = "asyncdepth";
+const string CoreWorkload::ASYNC_DEPTH_DEFAULT = "0";
+
+const string CoreWorkload::ASYNC_POOL_THREADS_PROPERTY = "asyncpoolthreads";
+const string CoreWorkload::ASYNC_POOL_THREADS_DEFAULT = "0";
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+inline void WriteHex32(char *p, uint32_t val) {
+  for (int i = 7; i >= 0; i--) {
+    p[i] = kHexDigits[val & 0xf];
+    val >>= 4;
+  }
+}
+
+inline bool ReadHex32(const char *p, uint32_t *val) {
+  uint32_t v = 0;
+  for (int i = 0; i < 8; i++) {
+    char c = p[i];
+    if (c >= '0' && c <= '9') {
+      v = (v << 4) | (c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      v = (v << 4) | (c - 'a' + 10);
+    } else {
+      return false;
+    }
+  }
+  *val = v;
+  return true;
+}
+
+inline uint32_t IntegrityTag(std::string_view key, std::string_view field_name) {
+  uint64_t h = ycsbc::utils::FNVHash64(key.data(), key.size());
+  return static_cast<uint32_t>(ycsbc::utils::FNVHash64(field_name.data(), field_name.size(), h));
+}
+
+inline uint64_t IntegritySeed(uint32_t tag, std::string_view field_name, uint32_t version) {
+  uint64_t h = ycsbc::utils::Hash((static_cast<uint64_t>(tag) << 32) | version);
+  return ycsbc::utils::FNVHash64(field_name.data(), field_name.size(), h);
+}
+
+// Generates (out != nullptr) or checks (out == nullptr) the printable body of a verifiable value.
+inline bool IntegrityBody(uint64_t seed, const char *in, char *out, size_t len) {
+  size_t i = 0;
+  while (i < len) {
+    uint64_t bits = ycsbc::utils::SplitMix64(seed);
+    for (int j = 0; j < 8 && i < len; j++, i++) {
+      char c = static_cast<char>(' ' + (bits & 0xff) % 95);
+      bits >>= 8;
+      if (out != nullptr) {
+        out[i] = c;
+      } else if (in[i] != c) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// A key of the bulk load: its table and the number its bytes are encoded from, which
+// is the key number after the insert order hashing.
+struct BulkKey {
+  uint64_t num;
+  uint32_t table;
+};
+
+// Orders bulk keys by table and then by the bytes their numbers encode to, without
+// building them.
+class BulkKeyLess {
+ public:
+  BulkKeyLess(ycsbc::KeyEncoding encoding, int zero_padding)
+      : encoding_(encoding), zero_padding_(zero_padding) {}
+
+  bool operator()(const BulkKey &a, const BulkKey &b) const {
+    if (a.table != b.table) {
+      return a.table < b.table;
+    }
+    switch (encoding_) {
+      case ycsbc::kKeyDecimal:
+        return DecimalLess(a.num, b.num);
+      case ycsbc::kKeyNative:
+        return memcmp(&a.num, &b.num, sizeof(uint64_t)) < 0;
+      default:
+        return a.num < b.num;
+    }
+  }
+
+ private:
+  // compares the zero padded digits, which only follow numeric order at equal widths
+  bool DecimalLess(uint64_t a, uint64_t b) const {
+    char digits_a[20], digits_b[20];
+    int len_a = std::to_chars(digits_a, digits_a + sizeof(digits_a), a).ptr - digits_a;
+    int len_b = std::to_chars(digits_b, digits_b + sizeof(digits_b), b).ptr - digits_b;
+    int width_a = std::max(zero_padding_, len_a);
+    int width_b = std::max(zero_padding_, len_b);
+    if (width_a == width_b) {
+      return a < b;
+    }
+    for (int i = 0; i < std::min(width_a, width_b); i++) {
+      char ca = i < width_a - len_a ? '0' : digits_a[i - (width_a - len_a)];
+      char cb = i < width_b - len_b ? '0' : digits_b[i - (width_b - len_b)];
+      if (ca != cb) {
+        return ca < cb;
+      }
+    }
+    return width_a < width_b;
+  }
+
+  ycsbc::KeyEncoding encoding_;
+  int zero_padding_;
+};
+
+} // anonymous
+
 namespace ycsbc {
 
+std::vector<std::string> CoreWorkload::TableNames(const utils::Properties &p) {
+  const std::string table_name = p.GetProperty(TABLENAME_PROPERTY, TABLENAME_DEFAULT);
+  int table_count = std::stoi(p.GetProperty(TABLE_COUNT_PROPERTY, TABLE_COUNT_DEFAULT));
+  if (table_count < 1) {
+    throw utils::Exception("Invalid table count: " + std::to_string(table_count));
+  }
+  if (table_count == 1) {
+    return {table_name};
+  }
+  std::vector<std::string> names;
+  for (int i = 0; i < table_count; i++) {
+    names.push_back(table_name + std::to_string(i));
+  }
+  return names;
+}
+
+int CoreWorkload::TableNumber(const std::vector<std::string> &names, std::string_view table) {
+  if (names.size() == 1) {
+    return table == names[0] ? 0 : -1;
+  }
+  // several tables are named tablename + 0, 1, ...
+  const size_t prefix = names[0].size() - 1;
+  if (table.size() <= prefix || table.compare(0, prefix, names[0], 0, prefix) != 0) {
+    return -1;
+  }
+  size_t n = 0;
+  for (size_t i = prefix; i < table.size(); i++) {
+    if (table[i] < '0' || table[i] > '9' || n >= names.size()) {
+      return -1;
+    }
+    n = n * 10 + (table[i] - '0');
+  }
+  return n < names.size() && table == names[n] ? static_cast<int>(n) : -1;
+}
+
+KeyEncoding CoreWorkload::GetKeyEncoding(const utils::Properties &p) {
+  bool fixed_key_8b = utils::StrToBool(p.GetProperty(FIXED_KEY_8B, FIXED_KEY_8B_DEFAULT));
+  if (!p.ContainsKey(KEY_ENCODING_PROPERTY)) {
+    return fixed_key_8b ? kKeyBigEndian : ParseKeyEncoding(KEY_ENCODING_DEFAULT);
+  }
+  KeyEncoding encoding = ParseKeyEncoding(p.GetProperty(KEY_ENCODING_PROPERTY));
+  if (fixed_key_8b && encoding != kKeyBigEndian && encoding != kKeyNative) {
+    throw utils::Exception(FIXED_KEY_8B + " requires an 8-byte key encoding");
+  }
+  return encoding;
+}
+
 void CoreWorkload::Init(const utils::Properties &p) {
   table_name_ = p.GetProperty(TABLENAME_PROPERTY,TABLENAME_DEFAULT);
+  table_names_ = TableNames(p);
+
+  std::string table_dist = p.GetProperty(TABLE_DISTRIBUTION_PROPERTY, TABLE_DISTRIBUTION_DEFAULT);
+  double table_theta = std::stod(p.GetProperty(TABLE_ZIPFIAN_CONST_PROPERTY,
+                                               TABLE_ZIPFIAN_CONST_DEFAULT));
+  double weight_sum = 0;
+  for (size_t i = 0; i < table_names_.size(); i++) {
+    if (table_dist == "uniform") {
+      weight_sum += 1.0;
+    } else if (table_dist == "zipfian") {
+      weight_sum += 1.0 / std::pow(i + 1, table_theta);
+    } else {
+      throw utils::Exception("Unknown table distribution: " + table_dist);
+    }
+    table_cdf_.push_back(weight_sum);
+  }
+  for (double &w : table_cdf_) {
+    w /= weight_sum;
+  }
 
   field_count_ = std::stoi(p.GetProperty(FIELD_COUNT_PROPERTY, FIELD_COUNT_DEFAULT));
   field_prefix_ = p.GetProperty(FIELD_NAME_PREFIX, FIELD_NAME_PREFIX_DEFAULT);
+  for (int i = 0; i < field_count_; i++) {
+    field_filters_.push_back({field_prefix_ + std::to_string(i)});
+  }
   field_len_generator_ = GetFieldLenGenerator(p);
 
   double read_proportion = std::stod(p.GetProperty(READ_PROPORTION_PROPERTY,
@@ -121,6 +361,10 @@ void CoreWorkload::Init(const utils::Properties &p) {
                                                      INSERT_PROPORTION_DEFAULT));
   double scan_proportion = std::stod(p.GetProperty(SCAN_PROPORTION_PROPERTY,
                                                    SCAN_PROPORTION_DEFAULT));
+  double reverse_scan_proportion = std::stod(p.GetProperty(REVERSE_SCAN_PROPORTION_PROPERTY,
+                                                           REVERSE_SCAN_PROPORTION_DEFAULT));
+  double range_scan_proportion = std::stod(p.GetProperty(RANGE_SCAN_PROPORTION_PROPERTY,
+                                                         RANGE_SCAN_PROPORTION_DEFAULT));
   double readmodifywrite_proportion = std::stod(p.GetProperty(
       READMODIFYWRITE_PROPORTION_PROPERTY, READMODIFYWRITE_PROPORTION_DEFAULT));
 
@@ -131,6 +375,10 @@ void CoreWorkload::Init(const utils::Properties &p) {
   int max_scan_len = std::stoi(p.GetProperty(MAX_SCAN_LENGTH_PROPERTY, MAX_SCAN_LENGTH_DEFAULT));
   std::string scan_len_dist = p.GetProperty(SCAN_LENGTH_DISTRIBUTION_PROPERTY,
                                             SCAN_LENGTH_DISTRIBUTION_DEFAULT);
+  int min_range_len = std::stoi(p.GetProperty(MIN_RANGE_LENGTH_PROPERTY, MIN_RANGE_LENGTH_DEFAULT));
+  int max_range_len = std::stoi(p.GetProperty(MAX_RANGE_LENGTH_PROPERTY, MAX_RANGE_LENGTH_DEFAULT));
+  std::string range_len_dist = p.GetProperty(RANGE_LENGTH_DISTRIBUTION_PROPERTY,
+                                             RANGE_LENGTH_DISTRIBUTION_DEFAULT);
   int insert_start = std::stoi(p.GetProperty(INSERT_START_PROPERTY, INSERT_START_DEFAULT));
 
   zero_padding_ = std::stoi(p.GetProperty(ZERO_PADDING_PROPERTY, ZERO_PADDING_DEFAULT));
@@ -139,15 +387,61 @@ void CoreWorkload::Init(const utils::Properties &p) {
                                                     READ_ALL_FIELDS_DEFAULT));
   write_all_fields_ = utils::StrToBool(p.GetProperty(WRITE_ALL_FIELDS_PROPERTY,
                                                      WRITE_ALL_FIELDS_DEFAULT));                               
-  fixed_key_8b_ = utils::StrToBool(p.GetProperty(FIXED_KEY_8B, FIXED_KEY_8B_DEFAULT));
+  key_encoding_ = GetKeyEncoding(p);
 
   fixed_field_len_ = utils::StrToBool(p.GetProperty(FIXED_FIELD_LEN, FIXED_FIELD_LEN_DEFAULT));
 
+  data_integrity_ = utils::StrToBool(p.GetProperty(DATA_INTEGRITY_PROPERTY,
+                                                   DATA_INTEGRITY_DEFAULT));
+  zero_copy_ = utils::StrToBool(p.GetProperty(ZERO_COPY_PROPERTY, ZERO_COPY_DEFAULT));
+  streaming_scan_ = utils::StrToBool(p.GetProperty(STREAMING_SCAN_PROPERTY,
+                                                   STREAMING_SCAN_DEFAULT));
+  async_depth_ = std::stoi(p.GetProperty(ASYNC_DEPTH_PROPERTY, ASYNC_DEPTH_DEFAULT));
+  AsyncPool::SetThreads(std::stoi(p.GetProperty(ASYNC_POOL_THREADS_PROPERTY,
+                                                ASYNC_POOL_THREADS_DEFAULT)));
+  const std::string load_mode = p.GetProperty(LOAD_MODE_PROPERTY, LOAD_MODE_DEFAULT);
+  if (load_mode == "bulk") {
+    bulk_load_ = true;
+  } else if (load_mode != "insert") {
+    throw utils::Exception("Unknown " + LOAD_MODE_PROPERTY + ": " + load_mode);
+  }
+  if (data_integrity_) {
+    // inserts of the run phase extend the key space by at most operationcount keys
+    size_t op_count = std::stoul(p.GetProperty(OPERATION_COUNT_PROPERTY, "0"));
+    key_versions_size_ = insert_start + record_count_ + op_count;
+    key_versions_ = new std::atomic<uint32_t>[key_versions_size_]();
+  }
+
   if (p.GetProperty(INSERT_ORDER_PROPERTY, INSERT_ORDER_DEFAULT) == "hashed") {
     ordered_inserts_ = false;
   } else {
     ordered_inserts_ = true;
   }
+  // with hashed keys a range between two key numbers is a random slice of the whole key
+  // space, read in full, so its latency says nothing
+  if (range_scan_proportion > 0 && !ordered_inserts_) {
+    throw utils::Exception(RANGE_SCAN_PROPORTION_PROPERTY + " needs " + INSERT_ORDER_PROPERTY +
+                           "=ordered");
+  }
+  // an end key sorting before its start key would cover the wrong slice of the key space,
+  // so the keys have to sort numerically up to the last key a range can end on
+  if (range_scan_proportion > 0) {
+    if (key_encoding_ == kKeyNative) {
+      throw utils::Exception(RANGE_SCAN_PROPORTION_PROPERTY + " needs an order preserving " +
+                             KEY_ENCODING_PROPERTY);
+    }
+    if (key_encoding_ == kKeyDecimal) {
+      // inserts of the run phase extend the key space by at most operationcount keys
+      uint64_t op_count = std::stoull(p.GetProperty(OPERATION_COUNT_PROPERTY, "0"));
+      uint64_t max_key_num = record_count_ + op_count + max_range_len;
+      int digits = static_cast<int>(std::to_string(max_key_num).size());
+      if (zero_padding_ < digits) {
+        throw utils::Exception(RANGE_SCAN_PROPORTION_PROPERTY + " needs " + ZERO_PADDING_PROPERTY +
+                               " of at least " + std::to_string(digits) +
+                               " or an order preserving " + KEY_ENCODING_PROPERTY);
+      }
+    }
+  }
 
 
   if (read_proportion > 0) {
@@ -162,6 +456,12 @@ void CoreWorkload::Init(const utils::Properties &p) {
   if (scan_proportion > 0) {
     op_chooser_.AddValue(SCAN, scan_proportion);
   }
+  if (reverse_scan_proportion > 0) {
+    op_chooser_.AddValue(REVERSE_SCAN, reverse_scan_proportion);
+  }
+  if (range_scan_proportion > 0) {
+    op_chooser_.AddValue(RANGE_SCAN, range_scan_proportion);
+  }
   if (readmodifywrite_proportion > 0) {
     op_chooser_.AddValue(READMODIFYWRITE, readmodifywrite_proportion);
   }
@@ -198,6 +498,14 @@ void CoreWorkload::Init(const utils::Properties &p) {
   } else {
     throw utils::Exception("Distribution not allowed for scan length: " + scan_len_dist);
   }
+
+  if (range_len_dist == "uniform") {
+    range_len_chooser_ = new UniformGenerator(min_range_len, max_range_len);
+  } else if (range_len_dist == "zipfian") {
+    range_len_chooser_ = new ZipfianGenerator(min_range_len, max_range_len);
+  } else {
+    throw utils::Exception("Distribution not allowed for range length: " + range_len_dist);
+  }
 }
 
 ycsbc::Generator<uint64_t> *CoreWorkload::GetFieldLenGenerator(
@@ -217,189 +525,365 @@ ycsbc::Generator<uint64_t> *CoreWorkload::GetFieldLenGenerator(
 }
 
 std::string CoreWorkload::BuildKeyName(uint64_t key_num) {
-  if(fixed_key_8b_) return BuildKeyName8B(key_num);
+  std::string key;
+  EncodeKey(KeyNumToEncode(key_num), &key);
+  return key;
+}
 
-  if (!ordered_inserts_) {
-    key_num = utils::Hash(key_num);
-  }
-  std::string prekey = "user";
-  std::string value = std::to_string(key_num);
-  int fill = std::max(0, zero_padding_ - static_cast<int>(value.size()));
-  return prekey.append(fill, '0').append(value);
+// The key of the zero-copy paths, built into a buffer of the calling thread that keeps
+// its capacity; valid until the thread's next call.
+const std::string &CoreWorkload::BuildKeyNameView(uint64_t key_num) {
+  static thread_local std::string key;
+  key.clear();
+  EncodeKey(KeyNumToEncode(key_num), &key);
+  return key;
 }
 
-std::string CoreWorkload::BuildKeyName8B(uint64_t key_num) {
-  if (!ordered_inserts_) {
-    key_num = utils::Hash(key_num);
+uint64_t CoreWorkload::KeyNumToEncode(uint64_t key_num) const {
+  return ordered_inserts_ ? key_num : utils::Hash(key_num);
+}
+
+void CoreWorkload::EncodeKey(uint64_t num, std::string *key) const {
+  if (key_encoding_ != kKeyDecimal) {
+    EncodeKeyNum(num, key_encoding_, key);
+    return;
   }
-  std::string key(8, '\0');
-  *reinterpret_cast<uint64_t*>(&key[0]) = key_num;
-  return key;
+  char digits[20];
+  int len = std::to_chars(digits, digits + sizeof(digits), num).ptr - digits;
+  key->append("user").append(std::max(0, zero_padding_ - len), '0').append(digits, len);
 }
 
-void CoreWorkload::BuildValues(std::vector<ycsbc::DB::Field> &values) {
-  if(fixed_field_len_) return BuildValuesFixedLen(values);
+void CoreWorkload::BuildValues(const std::string &key, uint32_t version,
+                               std::vector<ycsbc::DB::Field> &values) {
+  if(fixed_field_len_) return BuildValuesFixedLen(key, version, values);
 
   for (int i = 0; i < field_count_; ++i) {
     values.push_back(DB::Field());
     ycsbc::DB::Field &field = values.back();
     field.name.append(field_prefix_).append(std::to_string(i));
     uint64_t len = field_len_generator_->Next();
-    field.value.reserve(len);
-    RandomByteGenerator byte_generator;
-    std::generate_n(std::back_inserter(field.value), len, [&]() { return byte_generator.Next(); } );
+    FillValue(key, version, field, len);
   }
 }
 
-void CoreWorkload::BuildValuesFixedLen(std::vector<ycsbc::DB::Field> &values) {
+void CoreWorkload::BuildValuesFixedLen(const std::string &key, uint32_t version,
+                                       std::vector<ycsbc::DB::Field> &values) {
   for (int i = 0; i < field_count_; ++i) {
     values.push_back(DB::Field());
     ycsbc::DB::Field &field = values.back();
     field.name.append(field_prefix_).append(std::to_string(i));
     uint64_t len = field_len_generator_->Next();
     len = std::max<uint64_t>(0, len - sizeof(uint32_t) - sizeof(uint32_t) - field.name.size());
-    field.value.reserve(len);
-    RandomByteGenerator byte_generator;
-    std::generate_n(std::back_inserter(field.value), len, [&]() { return byte_generator.Next(); } );
+    FillValue(key, version, field, len);
   }
 }
 
-void CoreWorkload::BuildSingleValue(std::vector<ycsbc::DB::Field> &values) {
-  if(fixed_field_len_) return BuildValuesFixedLen(values);
+void CoreWorkload::BuildSingleValue(const std::string &key, uint32_t version,
+                                    std::vector<ycsbc::DB::Field> &values) {
+  if(fixed_field_len_) return BuildValuesFixedLen(key, version, values);
 
-  return BuildSingleValueFixedLen(values);
+  return BuildSingleValueFixedLen(key, version, values);
   values.push_back(DB::Field());
   ycsbc::DB::Field &field = values.back();
   field.name.append(NextFieldName());
   uint64_t len = field_len_generator_->Next();
-  field.value.reserve(len);
-  RandomByteGenerator byte_generator;
-  std::generate_n(std::back_inserter(field.value), len, [&]() { return byte_generator.Next(); } );
+  FillValue(key, version, field, len);
 }
 
-void CoreWorkload::BuildSingleValueFixedLen(std::vector<ycsbc::DB::Field> &values) {
+void CoreWorkload::BuildSingleValueFixedLen(const std::string &key, uint32_t version,
+                                            std::vector<ycsbc::DB::Field> &values) {
   values.push_back(DB::Field());
   ycsbc::DB::Field &field = values.back();
   field.name.append(NextFieldName());
   uint64_t len = field_len_generator_->Next();
   len = std::max<uint64_t>(0, len - sizeof(uint32_t) - sizeof(uint32_t) - field.name.size());
-  field.value.reserve(len);
-  RandomByteGenerator byte_generator;
-  std::generate_n(std::back_inserter(field.value), len, [&]() { return byte_generator.Next(); } );
+  FillValue(key, version, field, len);
 }
 
-uint64_t CoreWorkload::NextTransactionKeyNum() {
-  uint64_t key_num;
-  do {
-    key_num = key_chooser_->Next();
-  } while (key_num > transaction_insert_key_sequence_->Last());
-  return key_num;
+void CoreWorkload::FillValue(const std::string &key, uint32_t version, DB::Field &field,
+                             uint64_t len) {
+  if (!data_integrity_) {
+    field.value.reserve(len);
+    RandomByteGenerator byte_generator;
+    std::generate_n(std::back_inserter(field.value), len, [&]() { return byte_generator.Next(); } );
+    return;
+  }
+  // values shorter than the header cannot carry a version, so they are padded up
+  len = std::max<uint64_t>(len, kIntegrityHeaderLen);
+  uint32_t tag = IntegrityTag(key, field.name);
+  field.value.resize(len);
+  char *p = &field.value[0];
+  WriteHex32(p, version);
+  WriteHex32(p + 8, tag);
+  IntegrityBody(IntegritySeed(tag, field.name, version), nullptr, p + kIntegrityHeaderLen,
+                len - kIntegrityHeaderLen);
 }
 
-std::string CoreWorkload::NextFieldName() {
-  return std::string(field_prefix_).append(std::to_string(field_chooser_->Next()));
+uint32_t CoreWorkload::CommittedVersion(uint64_t key_num) const {
+  if (key_num >= key_versions_size_) {
+    return 0;
+  }
+  return key_versions_[key_num].load(std::memory_order_acquire);
 }
 
-bool CoreWorkload::DoInsert(DB &db) {
-  const std::string key = BuildKeyName(insert_key_sequence_->Next());
-  std::vector<DB::Field> fields;
-  BuildValues(fields);
-  return db.Insert(table_name_, key, fields) == DB::kOK;
+void CoreWorkload::CommitVersion(uint64_t key_num, uint32_t version) {
+  if (key_num >= key_versions_size_) {
+    return;
+  }
+  uint32_t prev = key_versions_[key_num].load(std::memory_order_relaxed);
+  while (prev < version
+         && !key_versions_[key_num].compare_exchange_weak(prev, version, std::memory_order_release));
 }
 
-bool CoreWorkload::DoTransaction(DB &db) {
-  DB::Status status;
-  switch (op_chooser_.Next()) {
-    case READ:
-      status = TransactionRead(db);
+CoreWorkload::VerifyResult CoreWorkload::VerifyField(const std::string *key, std::string_view name,
+                                                     std::string_view value,
+                                                     uint32_t *version) const {
+  uint32_t tag;
+  if (value.size() < kIntegrityHeaderLen || !ReadHex32(value.data(), version)
+      || !ReadHex32(value.data() + 8, &tag)) {
+    return kVerifyCorrupt;
+  }
+  // scans do not return keys, so only the self-consistency of the value is checked there
+  if (key != nullptr && tag != IntegrityTag(*key, name)) {
+    return kVerifyCorrupt;
+  }
+  if (!IntegrityBody(IntegritySeed(tag, name, *version), value.data() + kIntegrityHeaderLen,
+                     nullptr, value.size() - kIntegrityHeaderLen)) {
+    return kVerifyCorrupt;
+  }
+  return kVerifyOK;
+}
+
+CoreWorkload::VerifyResult CoreWorkload::VerifyRow(const std::string &key,
+                                                   const std::vector<std::string> *fields,
+                                                   uint32_t min_version,
+                                                   const std::vector<DB::Field> &values) const {
+  size_t expected = (fields != nullptr) ? fields->size() : static_cast<size_t>(field_count_);
+  if (values.size() != expected) {
+    return kVerifyCorrupt;
+  }
+  uint32_t max_version = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    if (fields != nullptr && values[i].name != (*fields)[i]) {
+      return kVerifyCorrupt;
+    }
+    uint32_t version;
+    if (VerifyField(&key, values[i].name, values[i].value, &version) != kVerifyOK) {
+      return kVerifyCorrupt;
+    }
+    max_version = std::max(max_version, version);
+  }
+  // with single-field updates, an untouched field legitimately keeps an older version,
+  // so a projected read can only be judged stale when every write covers all fields
+  if ((fields == nullptr || write_all_fields_) && max_version < min_version) {
+    return kVerifyStale;
+  }
+  return kVerifyOK;
+}
+
+void CoreWorkload::VerifyRead(const std::string &key, const std::vector<std::string> *fields,
+                              uint32_t min_version, const std::vector<DB::Field> &values) {
+  ScopedStage stage(STAGE_VERIFY);
+  utils::Timer<uint64_t, std::nano> timer;
+  timer.Start();
+  VerifyResult r = VerifyRow(key, fields, min_version, values);
+  uint64_t elapsed = timer.End();
+  if (measurements_ == nullptr) {
+    return;
+  }
+  switch (r) {
+    case kVerifyOK:
+      measurements_->Report(VERIFY, elapsed);
       break;
-    case UPDATE:
-      status = TransactionUpdate(db);
+    case kVerifyStale:
+      measurements_->Report(VERIFY_STALE, elapsed);
       break;
-    case INSERT:
-      status = TransactionInsert(db);
+    case kVerifyCorrupt:
+      measurements_->Report(VERIFY_CORRUPT, elapsed);
       break;
-    case SCAN:
-      status = TransactionScan(db);
+  }
+}
+
+void CoreWorkload::VerifyScan(const std::vector<std::vector<DB::Field>> &records) {
+  ScopedStage stage(STAGE_VERIFY);
+  utils::Timer<uint64_t, std::nano> timer;
+  timer.Start();
+  VerifyResult r = kVerifyOK;
+  for (const std::vector<DB::Field> &record : records) {
+    for (const DB::Field &field : record) {
+      uint32_t version;
+      if (VerifyField(nullptr, field.name, field.value, &version) != kVerifyOK) {
+        r = kVerifyCorrupt;
+        break;
+      }
+    }
+    if (r != kVerifyOK) {
       break;
-    case READMODIFYWRITE:
-      status = TransactionReadModifyWrite(db);
+    }
+  }
+  uint64_t elapsed = timer.End();
+  if (measurements_ != nullptr) {
+    measurements_->Report(r == kVerifyOK ? VERIFY : VERIFY_CORRUPT, elapsed);
+  }
+}
+
+// Checks one record of a streaming scan while its views are alive, adding the time taken
+// to elapsed so the caller reports it once after the scan.
+CoreWorkload::VerifyResult CoreWorkload::VerifyScanRecord(const std::vector<DB::FieldView> &record,
+                                                          uint64_t *elapsed) const {
+  ScopedStage stage(STAGE_VERIFY);
+  utils::Timer<uint64_t, std::nano> timer;
+  timer.Start();
+  VerifyResult r = kVerifyOK;
+  for (const DB::FieldView &field : record) {
+    uint32_t version;
+    if (VerifyField(nullptr, field.name, field.value, &version) != kVerifyOK) {
+      r = kVerifyCorrupt;
       break;
-    default:
-      throw utils::Exception("Operation request is not recognized!");
+    }
   }
-  return (status == DB::kOK);
+  *elapsed += timer.End();
+  return r;
 }
 
-DB::Status CoreWorkload::TransactionRead(DB &db) {
-  uint64_t key_num = NextTransactionKeyNum();
-  const std::string key = BuildKeyName(key_num);
-  std::vector<DB::Field> result;
-  if (!read_all_fields()) {
-    std::vector<std::string> fields;
-    fields.push_back(NextFieldName());
-    return db.Read(table_name_, key, &fields, result);
-  } else {
-    return db.Read(table_name_, key, NULL, result);
+// Materializes zero-copy results for the integrity checks, outside the timed region.
+std::vector<DB::Field> CoreWorkload::ToFields(const std::vector<DB::FieldView> &views) {
+  std::vector<DB::Field> fields;
+  fields.reserve(views.size());
+  for (const DB::FieldView &view : views) {
+    fields.push_back({std::string(view.name), std::string(view.value)});
   }
+  return fields;
 }
 
-DB::Status CoreWorkload::TransactionReadModifyWrite(DB &db) {
-  uint64_t key_num = NextTransactionKeyNum();
-  const std::string key = BuildKeyName(key_num);
-  std::vector<DB::Field> result;
+const std::string &CoreWorkload::TableName(uint64_t key_num) const {
+  if (table_names_.size() == 1) {
+    return table_names_[0];
+  }
+  // mixed independently of BuildKeyName's hashing so table choice does not follow key order
+  uint64_t state = key_num;
+  double u = (utils::SplitMix64(state) >> 11) * (1.0 / (1ull << 53));
+  size_t idx = std::upper_bound(table_cdf_.begin(), table_cdf_.end(), u) - table_cdf_.begin();
+  return table_names_[std::min(idx, table_names_.size() - 1)];
+}
 
-  if (!read_all_fields()) {
-    std::vector<std::string> fields;
-    fields.push_back(NextFieldName());
-    db.Read(table_name_, key, &fields, result);
-  } else {
-    db.Read(table_name_, key, NULL, result);
+uint64_t CoreWorkload::NextTransactionKeyNum() {
+  uint64_t key_num;
+  do {
+    key_num = key_chooser_->Next();
+  } while (key_num > transaction_insert_key_sequence_->Last());
+  return key_num;
+}
+
+std::string CoreWorkload::NextFieldName() {
+  return std::string(field_prefix_).append(std::to_string(field_chooser_->Next()));
+}
+
+// The single field projection of a read, shared so the zero-copy paths do not build one.
+const std::vector<std::string> *CoreWorkload::NextFieldFilter() {
+  return &field_filters_[field_chooser_->Next()];
+}
+
+///
+/// Merges the sorted key chunks of a bulk load, yielding the records of one
+/// table at a time with their values generated on the fly.
+///
+class CoreWorkload::BulkLoadStream : public DB::RecordStream {
+ public:
+  BulkLoadStream(CoreWorkload *workload, const std::vector<std::vector<BulkKey>> &chunks)
+      : workload_(workload), chunks_(chunks),
+        heap_(CursorGreater{&chunks, BulkKeyLess(workload->key_encoding_, workload->zero_padding_)}),
+        table_(0), count_(0) {
+    for (size_t c = 0; c < chunks.size(); c++) {
+      if (!chunks[c].empty()) {
+        heap_.push({c, 0});
+      }
+    }
   }
 
-  std::vector<DB::Field> values;
-  if (write_all_fields()) {
-    BuildValues(values);
-  } else {
-    BuildSingleValue(values);
+  void SetTable(uint32_t table) { table_ = table; }
+  size_t count() const { return count_; }
+
+  bool Next(std::string *key, std::vector<DB::Field> *values) {
+    if (heap_.empty() || Current(heap_.top()).table != table_) {
+      return false;
+    }
+    Cursor cursor = heap_.top();
+    heap_.pop();
+    key->clear();
+    workload_->EncodeKey(Current(cursor).num, key);
+    values->clear();
+    workload_->BuildValues(*key, 0, *values);
+    if (++cursor.pos < chunks_[cursor.chunk].size()) {
+      heap_.push(cursor);
+    }
+    count_++;
+    return true;
   }
-  return db.Update(table_name_, key, values);
-}
 
-DB::Status CoreWorkload::TransactionScan(DB &db) {
-  uint64_t key_num = NextTransactionKeyNum();
-  const std::string key = BuildKeyName(key_num);
-  int len = scan_len_chooser_->Next();
-  std::vector<std::vector<DB::Field>> result;
-  if (!read_all_fields()) {
-    std::vector<std::string> fields;
-    fields.push_back(NextFieldName());
-    return db.Scan(table_name_, key, len, &fields, result);
-  } else {
-    return db.Scan(table_name_, key, len, NULL, result);
+ private:
+  struct Cursor {
+    size_t chunk;
+    size_t pos;
+  };
+  struct CursorGreater {
+    const std::vector<std::vector<BulkKey>> *chunks;
+    BulkKeyLess less;
+    bool operator()(const Cursor &a, const Cursor &b) const {
+      return less((*chunks)[b.chunk][b.pos], (*chunks)[a.chunk][a.pos]);
+    }
+  };
+
+  const BulkKey &Current(const Cursor &cursor) const {
+    return chunks_[cursor.chunk][cursor.pos];
   }
-}
 
-DB::Status CoreWorkload::TransactionUpdate(DB &db) {
-  uint64_t key_num = NextTransactionKeyNum();
-  const std::string key = BuildKeyName(key_num);
-  std::vector<DB::Field> values;
-  if (write_all_fields()) {
-    BuildValues(values);
-  } else {
-    BuildSingleValue(values);
+  CoreWorkload *workload_;
+  const std::vector<std::vector<BulkKey>> &chunks_;
+  std::priority_queue<Cursor, std::vector<Cursor>, CursorGreater> heap_;
+  uint32_t table_;
+  size_t count_;
+};
+
+size_t CoreWorkload::BulkLoad(DB &db, size_t record_count, int num_threads) {
+  std::vector<std::vector<BulkKey>> chunks(num_threads);
+  std::vector<std::future<void>> sorters;
+  for (int i = 0; i < num_threads; i++) {
+    size_t chunk_size = record_count / num_threads;
+    if (static_cast<size_t>(i) < record_count % num_threads) {
+      chunk_size++;
+    }
+    sorters.emplace_back(std::async(std::launch::async, [this, &chunks, i, chunk_size] {
+      std::vector<BulkKey> &chunk = chunks[i];
+      chunk.reserve(chunk_size);
+      for (size_t n = 0; n < chunk_size; n++) {
+        uint64_t key_num = insert_key_sequence_->Next();
+        uint32_t table = &TableName(key_num) - table_names_.data();
+        chunk.push_back({KeyNumToEncode(key_num), table});
+      }
+      std::sort(chunk.begin(), chunk.end(), BulkKeyLess(key_encoding_, zero_padding_));
+    }));
+  }
+  for (std::future<void> &sorter : sorters) {
+    sorter.get();
+  }
+
+  BulkLoadStream stream(this, chunks);
+  for (uint32_t table = 0; table < table_names_.size(); table++) {
+    stream.SetTable(table);
+    if (db.BulkLoad(table_names_[table], stream) != DB::kOK) {
+      throw utils::Exception("Bulk load of table " + table_names_[table] + " failed");
+    }
   }
-  return db.Update(table_name_, key, values);
+  return stream.count();
 }
 
-DB::Status CoreWorkload::TransactionInsert(DB &db) {
-  uint64_t key_num = transaction_insert_key_sequence_->Next();
-  const std::string key = BuildKeyName(key_num);
-  std::vector<DB::Field> values;
-  BuildValues(values);
-  DB::Status s = db.Insert(table_name_, key, values);
-  transaction_insert_key_sequence_->Acknowledge(key_num);
-  return s;
+bool CoreWorkload::DoInsert(DB &db) {
+  return DoInsert<DB>(db);
+}
+
+bool CoreWorkload::DoTransaction(DB &db) {
+  return DoTransaction<DB>(db);
 }
 
 } // ycsbc
@@ -10,14 +10,17 @@
 #ifndef YCSB_C_CORE_WORKLOAD_H_
 #define YCSB_C_CORE_WORKLOAD_H_
 
+#include <atomic>
 #include <vector>
 #include <string>
+#include <string_view>
 #include "db.h"
 #include "properties.h"
 #include "generator.h"
 #include "discrete_generator.h"
 #include "counter_generator.h"
 #include "acknowledged_counter_generator.h"
+#include "key_codec.h"
 #include "utils.h"
 
 namespace ycsbc {
@@ -29,17 +32,26 @@ enum Operation {
   SCAN,
   READMODIFYWRITE,
   DELETE,
+  REVERSE_SCAN,
+  RANGE_SCAN,
   INSERT_FAILED,
   READ_FAILED,
   UPDATE_FAILED,
   SCAN_FAILED,
   READMODIFYWRITE_FAILED,
   DELETE_FAILED,
+  REVERSE_SCAN_FAILED,
+  RANGE_SCAN_FAILED,
+  VERIFY,
+  VERIFY_STALE,
+  VERIFY_CORRUPT,
   MAXOPTYPE
 };
 
 extern const char *kOperationString[MAXOPTYPE];
 
+class Measurements;
+
 class CoreWorkload {
  public:
   ///
@@ -48,6 +60,24 @@ class CoreWorkload {
   static const std::string TABLENAME_PROPERTY;
   static const std::string TABLENAME_DEFAULT;
 
+  ///
+  /// The number of tables to spread records over. With more than one table,
+  /// tables are named TABLENAME_PROPERTY followed by the table index.
+  /// Every key lives in exactly one table, chosen deterministically from the key.
+  ///
+  static const std::string TABLE_COUNT_PROPERTY;
+  static const std::string TABLE_COUNT_DEFAULT;
+
+  ///
+  /// The popularity distribution of tables. Options are "uniform" and "zipfian"
+  /// (table i holds a share of keys proportional to 1/(i+1)^TABLE_ZIPFIAN_CONST).
+  ///
+  static const std::string TABLE_DISTRIBUTION_PROPERTY;
+  static const std::string TABLE_DISTRIBUTION_DEFAULT;
+
+  static const std::string TABLE_ZIPFIAN_CONST_PROPERTY;
+  static const std::string TABLE_ZIPFIAN_CONST_DEFAULT;
+
   ///
   /// The name of the property for the number of fields in a record.
   ///
@@ -63,10 +93,19 @@ class CoreWorkload {
 
   ///
   /// whether the key length is fixed at 8 bytes. default false.
+  /// Shorthand for a binary KEY_ENCODING_PROPERTY, "bigendian" unless set otherwise.
   ///
   static const std::string FIXED_KEY_8B;
   static const std::string FIXED_KEY_8B_DEFAULT;
 
+  ///
+  /// The name of the property for the key encoding.
+  /// Options are "decimal", "bigendian", "varint" (order preserving) and
+  /// "native" (host byte order, the layout older fixedkey8b runs produced).
+  ///
+  static const std::string KEY_ENCODING_PROPERTY;
+  static const std::string KEY_ENCODING_DEFAULT;
+
   ///
   /// whether the field length (after serialization, 4B+4B+len(field.name)+len(field.value))
   /// is fixed. if true, for each field, the length of its serialized bytes array is fixed to 
@@ -119,6 +158,20 @@ class CoreWorkload {
   static const std::string SCAN_PROPORTION_PROPERTY;
   static const std::string SCAN_PROPORTION_DEFAULT;
 
+  ///
+  /// The name of the property for the proportion of reverse scan transactions,
+  /// which read the scan length records at or before the start key, newest first.
+  ///
+  static const std::string REVERSE_SCAN_PROPORTION_PROPERTY;
+  static const std::string REVERSE_SCAN_PROPORTION_DEFAULT;
+
+  ///
+  /// The name of the property for the proportion of bounded range scan
+  /// transactions, which read every record in [start key, end key).
+  ///
+  static const std::string RANGE_SCAN_PROPORTION_PROPERTY;
+  static const std::string RANGE_SCAN_PROPORTION_DEFAULT;
+
   ///
   /// The name of the property for the proportion of
   /// read-modify-write transactions.
@@ -158,6 +211,29 @@ class CoreWorkload {
   static const std::string SCAN_LENGTH_DISTRIBUTION_PROPERTY;
   static const std::string SCAN_LENGTH_DISTRIBUTION_DEFAULT;
 
+  ///
+  /// The name of the property for the min distance between the start and
+  /// end key number of a range scan, i.e. the number of records in the range.
+  /// Range scans need "ordered" inserts and keys that sort in numeric order;
+  /// decimal keys need a zeropadding covering the largest key a range reaches.
+  ///
+  static const std::string MIN_RANGE_LENGTH_PROPERTY;
+  static const std::string MIN_RANGE_LENGTH_DEFAULT;
+
+  ///
+  /// The name of the property for the max distance between the start and
+  /// end key number of a range scan.
+  ///
+  static const std::string MAX_RANGE_LENGTH_PROPERTY;
+  static const std::string MAX_RANGE_LENGTH_DEFAULT;
+
+  ///
+  /// The name of the property for the end key distribution of range scans.
+  /// Options are "uniform" and "zipfian" (favoring short ranges).
+  ///
+  static const std::string RANGE_LENGTH_DISTRIBUTION_PROPERTY;
+  static const std::string RANGE_LENGTH_DISTRIBUTION_DEFAULT;
+
   ///
   /// The name of the property for the order to insert records.
   /// Options are "ordered" or "hashed".
@@ -171,29 +247,120 @@ class CoreWorkload {
   static const std::string RECORD_COUNT_PROPERTY;
   static const std::string OPERATION_COUNT_PROPERTY;
 
+  ///
+  /// How the load phase writes records. Options are "insert" (one DB::Insert
+  /// per record from every client thread) and "bulk" (keys are generated and
+  /// sorted in parallel chunks, then streamed through DB::BulkLoad per table).
+  ///
+  static const std::string LOAD_MODE_PROPERTY;
+  static const std::string LOAD_MODE_DEFAULT;
+
   ///
   /// Field name prefix.
   ///
   static const std::string FIELD_NAME_PREFIX;
   static const std::string FIELD_NAME_PREFIX_DEFAULT;
 
+  ///
+  /// Whether values are generated deterministically from (key, field, version)
+  /// and verified on every read and scan. Verification runs outside the timed
+  /// region; results are reported as VERIFY, VERIFY-STALE and VERIFY-CORRUPT.
+  ///
+  static const std::string DATA_INTEGRITY_PROPERTY;
+  static const std::string DATA_INTEGRITY_DEFAULT;
+
+  ///
+  /// Whether reads and scans use the zero-copy DB::ReadView/ScanView calls,
+  /// which return slices into a per-thread arena instead of owned strings.
+  ///
+  static const std::string ZERO_COPY_PROPERTY;
+  static const std::string ZERO_COPY_DEFAULT;
+
+  ///
+  /// Whether scans stream records through DB::ScanVisit instead of
+  /// collecting them, taking precedence over zerocopy for scans.
+  ///
+  static const std::string STREAMING_SCAN_PROPERTY;
+  static const std::string STREAMING_SCAN_DEFAULT;
+
+  ///
+  /// Number of ops each client thread keeps in flight through the async DB
+  /// interface. Reads, updates and inserts are submitted asynchronously,
+  /// other ops run synchronously in between. 0 keeps every op synchronous.
+  ///
+  static const std::string ASYNC_DEPTH_PROPERTY;
+  static const std::string ASYNC_DEPTH_DEFAULT;
+
+  ///
+  /// Threads of the pool that runs async ops for bindings without native
+  /// async support, 0 for one per hardware thread.
+  ///
+  static const std::string ASYNC_POOL_THREADS_PROPERTY;
+  static const std::string ASYNC_POOL_THREADS_DEFAULT;
+
   ///
   /// Initialize the scenario.
   /// Called once, in the main client thread, before any operations are started.
   ///
   virtual void Init(const utils::Properties &p);
 
+  ///
+  /// Names of all tables the workload may touch. Bindings use this to
+  /// create per-table column families, tables or named databases up front.
+  ///
+  static std::vector<std::string> TableNames(const utils::Properties &p);
+
+  ///
+  /// Position of table in names as returned by TableNames, or -1 if it is not
+  /// one of them. Read off the number the names end with, without allocating,
+  /// so bindings can keep their per-table handles in a vector.
+  ///
+  static int TableNumber(const std::vector<std::string> &names, std::string_view table);
+
+  ///
+  /// Key encoding shared by the workload and bindings that decode keys.
+  ///
+  static KeyEncoding GetKeyEncoding(const utils::Properties &p);
+
   virtual bool DoInsert(DB &db);
   virtual bool DoTransaction(DB &db);
 
+  ///
+  /// Variants for a concrete DB type, defined in core_workload_impl.h. A
+  /// client thread specialized for one engine calls these, so that every call
+  /// into the DB is resolved at compile time.
+  ///
+  template <class DBType> bool DoInsert(DBType &db);
+  template <class DBType> bool DoTransaction(DBType &db);
+  ///
+  /// Starts one transaction through the async interface of db, adding one to
+  /// *in_flight if it is still running on return. The caller polls db for
+  /// completions and subtracts them from *in_flight.
+  ///
+  template <class DBType> void DoTransactionAsync(DBType &db, int *in_flight);
+
+  ///
+  /// Loads record_count records through db.BulkLoad, generating and sorting
+  /// the keys on num_threads threads.
+  /// @return The number of records loaded.
+  ///
+  size_t BulkLoad(DB &db, size_t record_count, int num_threads);
+
+  bool bulk_load() const { return bulk_load_; }
+  int async_depth() const { return async_depth_; }
   bool read_all_fields() const { return read_all_fields_; }
   bool write_all_fields() const { return write_all_fields_; }
 
+  void SetMeasurements(Measurements *measurements) {
+    measurements_ = measurements;
+  }
+
   CoreWorkload() :
-      field_count_(0), read_all_fields_(false), write_all_fields_(false), fixed_key_8b_(false), fixed_field_len_(false),
-      field_len_generator_(nullptr), key_chooser_(nullptr), field_chooser_(nullptr),
-      scan_len_chooser_(nullptr), insert_key_sequence_(nullptr),
-      transaction_insert_key_sequence_(nullptr), ordered_inserts_(true), record_count_(0) {
+      field_count_(0), read_all_fields_(false), write_all_fields_(false), key_encoding_(kKeyDecimal), fixed_field_len_(false),
+      data_integrity_(false), zero_copy_(false), streaming_scan_(false), bulk_load_(false), async_depth_(0), field_len_generator_(nullptr), key_chooser_(nullptr), field_chooser_(nullptr),
+      scan_len_chooser_(nullptr), range_len_chooser_(nullptr), insert_key_sequence_(nullptr),
+      transaction_insert_key_sequence_(nullptr), ordered_inserts_(true), record_count_(0),
+      key_versions_(nullptr), key_versions_size_(0), measurements_(nullptr) {
   }
 
   virtual ~CoreWorkload() {
@@ -201,45 +368,112 @@ class CoreWorkload {
     delete key_chooser_;
     delete field_chooser_;
     delete scan_len_chooser_;
+    delete range_len_chooser_;
     delete insert_key_sequence_;
     delete transaction_insert_key_sequence_;
+    delete[] key_versions_;
   }
 
  protected:
+  class BulkLoadStream;
+
+  ///
+  /// Buffers of an async op, owned by its completion.
+  ///
+  struct AsyncOp {
+    uint64_t key_num;
+    uint32_t version;
+    std::string key;
+    std::vector<std::string> fields;
+    std::vector<DB::Field> values;
+  };
+
   static Generator<uint64_t> *GetFieldLenGenerator(const utils::Properties &p);
   std::string BuildKeyName(uint64_t key_num);
-  std::string BuildKeyName8B(uint64_t key_num);
-  void BuildValues(std::vector<DB::Field> &values);
-  void BuildValuesFixedLen(std::vector<DB::Field> &values);
-  void BuildSingleValue(std::vector<DB::Field> &update);
-  void BuildSingleValueFixedLen(std::vector<DB::Field> &update);
-
+  const std::string &BuildKeyNameView(uint64_t key_num);
+  uint64_t KeyNumToEncode(uint64_t key_num) const;
+  void EncodeKey(uint64_t num, std::string *key) const;
+  void BuildValues(const std::string &key, uint32_t version, std::vector<DB::Field> &values);
+  void BuildValuesFixedLen(const std::string &key, uint32_t version,
+                           std::vector<DB::Field> &values);
+  void BuildSingleValue(const std::string &key, uint32_t version, std::vector<DB::Field> &update);
+  void BuildSingleValueFixedLen(const std::string &key, uint32_t version,
+                                std::vector<DB::Field> &update);
+  void FillValue(const std::string &key, uint32_t version, DB::Field &field, uint64_t len);
+
+  ///
+  /// Data integrity helpers. A verifiable value is laid out as
+  /// [8B hex version][8B hex tag][body], where tag is derived from (key, field)
+  /// and body is a deterministic stream seeded from (tag, field, version).
+  ///
+  enum VerifyResult {
+    kVerifyOK,
+    kVerifyStale,
+    kVerifyCorrupt
+  };
+  static constexpr size_t kIntegrityHeaderLen = 16;
+  uint32_t CommittedVersion(uint64_t key_num) const;
+  void CommitVersion(uint64_t key_num, uint32_t version);
+  VerifyResult VerifyField(const std::string *key, std::string_view name, std::string_view value,
+                           uint32_t *version) const;
+  VerifyResult VerifyRow(const std::string &key, const std::vector<std::string> *fields,
+                         uint32_t min_version, const std::vector<DB::Field> &values) const;
+  void VerifyRead(const std::string &key, const std::vector<std::string> *fields,
+                  uint32_t min_version, const std::vector<DB::Field> &values);
+  void VerifyScan(const std::vector<std::vector<DB::Field>> &records);
+  VerifyResult VerifyScanRecord(const std::vector<DB::FieldView> &record, uint64_t *elapsed) const;
+
+  static std::vector<DB::Field> ToFields(const std::vector<DB::FieldView> &views);
+
+  const std::string &TableName(uint64_t key_num) const;
   uint64_t NextTransactionKeyNum();
   std::string NextFieldName();
-
-  DB::Status TransactionRead(DB &db);
-  DB::Status TransactionReadModifyWrite(DB &db);
-  DB::Status TransactionScan(DB &db);
-  DB::Status TransactionUpdate(DB &db);
-  DB::Status TransactionInsert(DB &db);
+  const std::vector<std::string> *NextFieldFilter();
+
+  template <class DBType> DB::Status Transaction(DBType &db, Operation op);
+  template <class DBType> DB::Status TransactionRead(DBType &db);
+  template <class DBType> DB::Status TransactionReadView(DBType &db);
+  template <class DBType> DB::Status TransactionReadModifyWrite(DBType &db);
+  template <class DBType> DB::Status TransactionScan(DBType &db);
+  template <class DBType> DB::Status TransactionScanView(DBType &db);
+  template <class DBType> DB::Status TransactionScanVisit(DBType &db);
+  template <class DBType> DB::Status TransactionReverseScan(DBType &db);
+  template <class DBType> DB::Status TransactionRangeScan(DBType &db);
+  template <class DBType> DB::Status TransactionUpdate(DBType &db);
+  template <class DBType> DB::Status TransactionInsert(DBType &db);
+  template <class DBType> void SubmitTransactionRead(DBType &db);
+  template <class DBType> void SubmitTransactionUpdate(DBType &db);
+  template <class DBType> void SubmitTransactionInsert(DBType &db);
 
   std::string table_name_;
+  std::vector<std::string> table_names_;
+  std::vector<double> table_cdf_;
   int field_count_;
   std::string field_prefix_;
+  std::vector<std::vector<std::string>> field_filters_; // {prefix + i} for field i
   bool read_all_fields_;
   bool write_all_fields_;
-  bool fixed_key_8b_;
+  KeyEncoding key_encoding_;
   bool fixed_field_len_;
+  bool data_integrity_;
+  bool zero_copy_;
+  bool streaming_scan_;
+  bool bulk_load_;
+  int async_depth_;
   Generator<uint64_t> *field_len_generator_;
   DiscreteGenerator<Operation> op_chooser_;
   Generator<uint64_t> *key_chooser_; // transaction key gen
   Generator<uint64_t> *field_chooser_;
   Generator<uint64_t> *scan_len_chooser_;
+  Generator<uint64_t> *range_len_chooser_;
   CounterGenerator *insert_key_sequence_; // load insert key gen
   AcknowledgedCounterGenerator *transaction_insert_key_sequence_; // transaction insert key gen
   bool ordered_inserts_;
   size_t record_count_;
   int zero_padding_;
+  std::atomic<uint32_t> *key_versions_; // last committed version per key, dataintegrity only
+  size_t key_versions_size_;
+  Measurements *measurements_;
 };
 
 } // ycsbc
@@ -9,10 +9,16 @@
 #ifndef YCSB_C_DB_H_
 #define YCSB_C_DB_H_
 
+#include "arena.h"
+#include "async_pool.h"
 #include "properties.h"
 
+#include <exception>
+#include <functional>
+#include <ostream>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace ycsbc {
 
@@ -26,6 +32,31 @@ class DB {
     std::string name;
     std::string value;
   };
+  ///
+  /// Field returned by the zero-copy calls, pointing into memory owned by
+  /// the DB instance. Valid until the next *View call on the same instance.
+  ///
+  struct FieldView {
+    std::string_view name;
+    std::string_view value;
+  };
+  ///
+  /// Receives one record of a ScanVisit. The views are only valid during the
+  /// call; returning false ends the scan early.
+  ///
+  typedef std::function<bool(const std::vector<FieldView> &)> ScanVisitor;
+  ///
+  /// Source of the records handed to BulkLoad, in ascending key order.
+  ///
+  class RecordStream {
+   public:
+    virtual ~RecordStream() { }
+    ///
+    /// Replaces key and values with the next record.
+    /// @return false once the stream is exhausted.
+    ///
+    virtual bool Next(std::string *key, std::vector<Field> *values) = 0;
+  };
   enum Status {
     kOK = 0,
     kError,
@@ -33,6 +64,11 @@ class DB {
     kNotImplemented
   };
   ///
+  /// Called with the status of an async op once it completes, on the thread
+  /// that submitted it, from Poll.
+  ///
+  typedef std::function<void(Status)> Completion;
+  ///
   /// Initializes any state for accessing this DB.
   ///
   virtual void Init() { }
@@ -69,6 +105,89 @@ class DB {
                    int record_count, const std::vector<std::string> *fields,
                    std::vector<std::vector<Field>> &result) = 0;
   ///
+  /// Performs a reverse range scan, starting from the last record whose key is
+  /// not greater than key and moving towards smaller keys.
+  ///
+  /// @param table The name of the table.
+  /// @param key The upper (inclusive) bound of the scan.
+  /// @param record_count The number of records to read.
+  /// @param fields The list of fields to read, or NULL for all of them.
+  /// @param result A vector of vector, where each vector contains field/value
+  ///        pairs for one record, in descending key order
+  /// @return Zero on success, or a non-zero error code on error.
+  ///
+  virtual Status ReverseScan(const std::string &table, const std::string &key,
+                          int record_count, const std::vector<std::string> *fields,
+                          std::vector<std::vector<Field>> &result) {
+    return kNotImplemented;
+  }
+  ///
+  /// Reads every record whose key lies in [start_key, end_key).
+  ///
+  /// @param table The name of the table.
+  /// @param start_key The inclusive lower bound of the range.
+  /// @param end_key The exclusive upper bound of the range.
+  /// @param fields The list of fields to read, or NULL for all of them.
+  /// @param result A vector of vector, where each vector contains field/value
+  ///        pairs for one record, in ascending key order
+  /// @return Zero on success, or a non-zero error code on error.
+  ///
+  virtual Status RangeScan(const std::string &table, const std::string &start_key,
+                        const std::string &end_key, const std::vector<std::string> *fields,
+                        std::vector<std::vector<Field>> &result) {
+    return kNotImplemented;
+  }
+  ///
+  /// Zero-copy variant of Read. The default adapts Read for bindings without
+  /// a native implementation, copying the result once into the arena.
+  ///
+  virtual Status ReadView(std::string_view table, std::string_view key,
+                          const std::vector<std::string> *fields,
+                          std::vector<FieldView> &result) {
+    arena_.Reset();
+    std::vector<Field> values;
+    Status s = Read(std::string(table), std::string(key), fields, values);
+    CopyToArena(values, result);
+    return s;
+  }
+  ///
+  /// Zero-copy variant of Scan, see ReadView.
+  ///
+  virtual Status ScanView(std::string_view table, std::string_view key, int record_count,
+                          const std::vector<std::string> *fields,
+                          std::vector<std::vector<FieldView>> &result) {
+    arena_.Reset();
+    std::vector<std::vector<Field>> records;
+    Status s = Scan(std::string(table), std::string(key), record_count, fields, records);
+    result.resize(records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+      CopyToArena(records[i], result[i]);
+    }
+    return s;
+  }
+  ///
+  /// Streaming variant of Scan: hands each record to visitor as it is read,
+  /// as views into memory pinned by the binding, instead of collecting the
+  /// whole result. The default adapts Scan for bindings without a native
+  /// implementation.
+  ///
+  virtual Status ScanVisit(std::string_view table, std::string_view key, int record_count,
+                           const std::vector<std::string> *fields, const ScanVisitor &visitor) {
+    std::vector<std::vector<Field>> records;
+    Status s = Scan(std::string(table), std::string(key), record_count, fields, records);
+    std::vector<FieldView> views;
+    for (const std::vector<Field> &record : records) {
+      views.clear();
+      for (const Field &field : record) {
+        views.push_back({field.name, field.value});
+      }
+      if (!visitor(views)) {
+        break;
+      }
+    }
+    return s;
+  }
+  ///
   /// Updates a record in the database.
   /// Field/value pairs in the specified vector are written to the record,
   /// overwriting any existing values with the same field names.
@@ -99,6 +218,76 @@ class DB {
   /// @return Zero on success, a non-zero error code on error.
   ///
   virtual Status Delete(const std::string &table, const std::string &key) = 0;
+  ///
+  /// Loads every record of a stream into an empty table through the engine's
+  /// bulk import path. The default inserts the records one by one.
+  ///
+  /// @param table The name of the table.
+  /// @param records The records to load, in strictly ascending key order.
+  /// @return Zero on success, a non-zero error code on error.
+  ///
+  virtual Status BulkLoad(const std::string &table, RecordStream &records) {
+    std::string key;
+    std::vector<Field> values;
+    while (records.Next(&key, &values)) {
+      Status s = Insert(table, key, values);
+      if (s != kOK) {
+        return s;
+      }
+    }
+    return kOK;
+  }
+
+  ///
+  /// Asynchronous variants of Read, Update and Insert. They return as soon as
+  /// the op is submitted; done runs from a later Poll. Every argument must stay
+  /// valid until then. The defaults run the synchronous call on the shared
+  /// AsyncPool, or inline for instances that are not ThreadSafe.
+  ///
+  virtual void SubmitRead(const std::string &table, const std::string &key,
+                          const std::vector<std::string> *fields, std::vector<Field> *result,
+                          Completion done) {
+    SubmitToPool([this, &table, &key, fields, result] {
+      return Read(table, key, fields, *result);
+    }, std::move(done));
+  }
+  virtual void SubmitUpdate(const std::string &table, const std::string &key,
+                            std::vector<Field> *values, Completion done) {
+    SubmitToPool([this, &table, &key, values] {
+      return Update(table, key, *values);
+    }, std::move(done));
+  }
+  virtual void SubmitInsert(const std::string &table, const std::string &key,
+                            std::vector<Field> *values, Completion done) {
+    SubmitToPool([this, &table, &key, values] {
+      return Insert(table, key, *values);
+    }, std::move(done));
+  }
+  ///
+  /// Runs the completions of finished async ops, first waiting until at
+  /// least min_completions have finished.
+  /// @return The number of completions run.
+  ///
+  virtual int Poll(int min_completions) {
+    return completions_.Drain(min_completions);
+  }
+
+  ///
+  /// Called on one instance before the client threads of a phase ("Load" or
+  /// "Run") start, before Init for the first phase.
+  ///
+  virtual void PhaseBegin(const std::string &phase) { }
+  ///
+  /// Engine counters appended to each status line, covering the interval since
+  /// the previous call. Called from the status thread on one instance while the
+  /// others run ops, so it may only read state that is safe to share.
+  ///
+  virtual std::string StatusMsg() { return ""; }
+  ///
+  /// Prints the engine counters of the phase that just ended. Called once all
+  /// client threads are done, possibly after Cleanup.
+  ///
+  virtual void PhaseReport(std::ostream &out, const std::string &phase) { }
 
   virtual ~DB() { }
 
@@ -106,7 +295,54 @@ class DB {
     props_ = props;
   }
  protected:
+  ///
+  /// Whether calls on this instance may run on several threads at once, as the
+  /// default async ops need. Bindings holding single-threaded handles say no.
+  ///
+  virtual bool ThreadSafe() const { return true; }
+  ///
+  /// Runs op for the default async interface and queues its completion. An
+  /// exception thrown by op is rethrown by Poll on the submitting thread.
+  ///
+  void SubmitToPool(std::function<Status()> op, Completion done) {
+    auto run = [this, op, done] {
+      try {
+        Status s = op();
+        completions_.Push([done, s] { done(s); });
+      } catch (...) {
+        std::exception_ptr error = std::current_exception();
+        completions_.Push([error] { std::rethrow_exception(error); });
+      }
+    };
+    if (ThreadSafe()) {
+      AsyncPool::Shared().Submit(run);
+    } else {
+      run();
+    }
+  }
+  ///
+  /// Appends a copy of a visited record, for bindings that implement Scan on
+  /// top of ScanVisit.
+  ///
+  static void AppendRecord(const std::vector<FieldView> &record,
+                           std::vector<std::vector<Field>> &result) {
+    result.emplace_back();
+    result.back().reserve(record.size());
+    for (const FieldView &field : record) {
+      result.back().push_back({std::string(field.name), std::string(field.value)});
+    }
+  }
+  void CopyToArena(const std::vector<Field> &values, std::vector<FieldView> &result) {
+    result.clear();
+    result.reserve(values.size());
+    for (const Field &field : values) {
+      result.push_back({arena_.Copy(field.name), arena_.Copy(field.value)});
+    }
+  }
+
   utils::Properties *props_;
+  Arena arena_; // backs the views of the last *View call, recycled by the next one
+  CompletionQueue completions_; // async ops finished by SubmitToPool, run by Poll
 };
 
 } // ycsbc
@@ -8,31 +8,77 @@
 
 #include "db_factory.h"
 #include "basic_db.h"
+#include "client.h"
 #include "db_wrapper.h"
+#include "flight_recorder.h"
+#include "utils.h"
 
 namespace ycsbc {
 
+const std::string DBFactory::STATIC_DISPATCH_PROPERTY = "staticdispatch";
+const std::string DBFactory::STATIC_DISPATCH_DEFAULT = "true";
 
 std::map<std::string, DBFactory::DBCreator> &DBFactory::Registry() {
   static std::map<std::string, DBCreator> registry;
   return registry;
 }
 
+std::map<std::string, std::vector<DBFactory::StaticClient>> &DBFactory::ClientRegistry() {
+  static std::map<std::string, std::vector<StaticClient>> registry;
+  return registry;
+}
+
 bool DBFactory::RegisterDB(std::string db_name, DBCreator db_creator) {
   Registry()[db_name] = db_creator;
   return true;
 }
 
+bool DBFactory::RegisterClient(std::string db_name, FormatMatcher matcher, WrappedCreator creator,
+                               ClientRunner runner) {
+  ClientRegistry()[db_name].push_back({matcher, creator, runner});
+  return true;
+}
+
+const DBFactory::StaticClient *DBFactory::FindClient(utils::Properties *props) {
+  if (!utils::StrToBool(props->GetProperty(STATIC_DISPATCH_PROPERTY, STATIC_DISPATCH_DEFAULT))) {
+    return nullptr;
+  }
+  std::string db_name = props->GetProperty("dbname", "basic");
+  std::map<std::string, std::vector<StaticClient>> &registry = ClientRegistry();
+  auto it = registry.find(db_name);
+  if (it == registry.end()) {
+    return nullptr;
+  }
+  for (const StaticClient &client : it->second) {
+    if (client.matcher(*props)) {
+      return &client;
+    }
+  }
+  return nullptr;
+}
+
 DB *DBFactory::CreateDB(utils::Properties *props, Measurements *measurements) {
+  const StaticClient *client = FindClient(props);
+  if (client != nullptr) {
+    return client->creator(props, measurements);
+  }
   std::string db_name = props->GetProperty("dbname", "basic");
   DB *db = nullptr;
   std::map<std::string, DBCreator> &registry = Registry();
   if (registry.find(db_name) != registry.end()) {
     DB *new_db = (*registry[db_name])();
     new_db->SetProps(props);
-    db = new DBWrapper(new_db, measurements);
+    db = new DBWrapper<>(new_db, measurements, FlightRecorder::Create(*props));
   }
   return db;
 }
 
+DBFactory::ClientRunner DBFactory::GetClient(utils::Properties *props) {
+  const StaticClient *client = FindClient(props);
+  if (client != nullptr) {
+    return client->runner;
+  }
+  return ClientThread<CoreWorkload, DB>;
+}
+
 } // ycsbc
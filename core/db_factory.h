@@ -12,22 +12,61 @@
 #include "db.h"
 #include "measurements.h"
 #include "properties.h"
+#include "countdown_latch.h"
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace ycsbc {
 
+class CoreWorkload;
+
 class DBFactory {
  public:
   using DBCreator = DB *(*)();
+  ///
+  /// Runs one client thread over a DB returned by CreateDB.
+  ///
+  using ClientRunner = int (*)(DB *db, CoreWorkload *wl, int num_ops, bool is_loading,
+                               bool init_db, bool cleanup_db, CountDownLatch *latch);
+  ///
+  /// Creates an engine already wrapped for measurement, see RegisterStaticDB.
+  ///
+  using WrappedCreator = DB *(*)(utils::Properties *props, Measurements *measurements);
+  ///
+  /// Tells whether the run configured by props uses the format a statically
+  /// dispatched specialization was compiled for.
+  ///
+  using FormatMatcher = bool (*)(const utils::Properties &props);
+
+  ///
+  /// The name of the property that selects the statically dispatched client
+  /// threads when one matches the run (default true).
+  ///
+  static const std::string STATIC_DISPATCH_PROPERTY;
+  static const std::string STATIC_DISPATCH_DEFAULT;
+
   static bool RegisterDB(std::string db_name, DBCreator db_creator);
+  static bool RegisterClient(std::string db_name, FormatMatcher matcher, WrappedCreator creator,
+                             ClientRunner runner);
   static DB *CreateDB(utils::Properties *props, Measurements *measurements);
+  ///
+  /// The client thread to run the DBs from CreateDB with: a specialization
+  /// registered for the selected db and format, or the virtual dispatch path.
+  ///
+  static ClientRunner GetClient(utils::Properties *props);
  private:
+  struct StaticClient {
+    FormatMatcher matcher;
+    WrappedCreator creator;
+    ClientRunner runner;
+  };
   static std::map<std::string, DBCreator> &Registry();
+  static std::map<std::string, std::vector<StaticClient>> &ClientRegistry();
+  static const StaticClient *FindClient(utils::Properties *props);
 };
 
 } // ycsbc
 
 #endif // YCSB_C_DB_FACTORY_H_
-
@@ -12,16 +12,26 @@
 #include <vector>
 
 #include "db.h"
+#include "flight_recorder.h"
 #include "measurements.h"
+#include "stage_breakdown.h"
 #include "timer.h"
 #include "utils.h"
 
 namespace ycsbc {
 
-class DBWrapper : public DB {
+///
+/// Times every call into the wrapped DB. Engine is DB for the virtual path,
+/// or a final binding class, in which case every call below is direct.
+///
+template <class Engine = DB>
+class DBWrapper final : public DB {
  public:
-  DBWrapper(DB *db, Measurements *measurements) : db_(db), measurements_(measurements) {}
+  DBWrapper(Engine *db, Measurements *measurements, FlightRecorder *recorder = nullptr)
+      : db_(db), measurements_(measurements), recorder_(recorder),
+        sample_rate_(measurements->sample_rate()), sample_countdown_(1) {}
   ~DBWrapper() {
+    delete recorder_;
     delete db_;
   }
   void Init() {
@@ -32,65 +42,196 @@ class DBWrapper : public DB {
   }
   Status Read(const std::string &table, const std::string &key,
               const std::vector<std::string> *fields, std::vector<Field> &result) {
-    timer_.Start();
-    Status s = db_->Read(table, key, fields, result);
-    uint64_t elapsed = timer_.End();
-    if (s == kOK) {
-      measurements_->Report(READ, elapsed);
-    } else {
-      measurements_->Report(READ_FAILED, elapsed);
-    }
-    return s;
+    return Measure(READ, READ_FAILED, key, [&] {
+      return db_->Read(table, key, fields, result);
+    });
   }
   Status Scan(const std::string &table, const std::string &key, int record_count,
               const std::vector<std::string> *fields, std::vector<std::vector<Field>> &result) {
-    timer_.Start();
-    Status s = db_->Scan(table, key, record_count, fields, result);
-    uint64_t elapsed = timer_.End();
-    if (s == kOK) {
-      measurements_->Report(SCAN, elapsed);
-    } else {
-      measurements_->Report(SCAN_FAILED, elapsed);
-    }
-    return s;
+    return Measure(SCAN, SCAN_FAILED, key, [&] {
+      return db_->Scan(table, key, record_count, fields, result);
+    });
+  }
+  Status ReadView(std::string_view table, std::string_view key,
+                  const std::vector<std::string> *fields, std::vector<FieldView> &result) {
+    return Measure(READ, READ_FAILED, key, [&] {
+      return db_->ReadView(table, key, fields, result);
+    });
+  }
+  Status ScanView(std::string_view table, std::string_view key, int record_count,
+                  const std::vector<std::string> *fields,
+                  std::vector<std::vector<FieldView>> &result) {
+    return Measure(SCAN, SCAN_FAILED, key, [&] {
+      return db_->ScanView(table, key, record_count, fields, result);
+    });
+  }
+  Status ScanVisit(std::string_view table, std::string_view key, int record_count,
+                   const std::vector<std::string> *fields, const ScanVisitor &visitor) {
+    return Measure(SCAN, SCAN_FAILED, key, [&] {
+      return db_->ScanVisit(table, key, record_count, fields, visitor);
+    });
+  }
+  Status ReverseScan(const std::string &table, const std::string &key, int record_count,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    return Measure(REVERSE_SCAN, REVERSE_SCAN_FAILED, key, [&] {
+      return db_->ReverseScan(table, key, record_count, fields, result);
+    });
+  }
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    return Measure(RANGE_SCAN, RANGE_SCAN_FAILED, start_key, [&] {
+      return db_->RangeScan(table, start_key, end_key, fields, result);
+    });
   }
   Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
-    timer_.Start();
-    Status s = db_->Update(table, key, values);
-    uint64_t elapsed = timer_.End();
-    if (s == kOK) {
-      measurements_->Report(UPDATE, elapsed);
-    } else {
-      measurements_->Report(UPDATE_FAILED, elapsed);
-    }
-    return s;
+    return Measure(UPDATE, UPDATE_FAILED, key, [&] {
+      return db_->Update(table, key, values);
+    });
   }
   Status Insert(const std::string &table, const std::string &key, std::vector<Field> &values) {
-    timer_.Start();
-    Status s = db_->Insert(table, key, values);
-    uint64_t elapsed = timer_.End();
-    if (s == kOK) {
-      measurements_->Report(INSERT, elapsed);
-    } else {
-      measurements_->Report(INSERT_FAILED, elapsed);
+    return Measure(INSERT, INSERT_FAILED, key, [&] {
+      return db_->Insert(table, key, values);
+    });
+  }
+  Status Delete(const std::string &table, const std::string &key) {
+    return Measure(DELETE, DELETE_FAILED, key, [&] {
+      return db_->Delete(table, key);
+    });
+  }
+  void SubmitRead(const std::string &table, const std::string &key,
+                  const std::vector<std::string> *fields, std::vector<Field> *result,
+                  Completion done) {
+    db_->SubmitRead(table, key, fields, result, MeasureAsync(READ, READ_FAILED, key, std::move(done)));
+  }
+  void SubmitUpdate(const std::string &table, const std::string &key,
+                    std::vector<Field> *values, Completion done) {
+    db_->SubmitUpdate(table, key, values, MeasureAsync(UPDATE, UPDATE_FAILED, key, std::move(done)));
+  }
+  void SubmitInsert(const std::string &table, const std::string &key,
+                    std::vector<Field> *values, Completion done) {
+    db_->SubmitInsert(table, key, values, MeasureAsync(INSERT, INSERT_FAILED, key, std::move(done)));
+  }
+  int Poll(int min_completions) {
+    return db_->Poll(min_completions);
+  }
+  void PhaseBegin(const std::string &phase) {
+    db_->PhaseBegin(phase);
+  }
+  std::string StatusMsg() {
+    return db_->StatusMsg();
+  }
+  void PhaseReport(std::ostream &out, const std::string &phase) {
+    db_->PhaseReport(out, phase);
+  }
+  ///
+  /// A bulk load has no per-record latency; each record is counted as an
+  /// untimed insert.
+  ///
+  Status BulkLoad(const std::string &table, RecordStream &records) {
+    CountedStream counted(records, measurements_);
+    return db_->BulkLoad(table, counted);
+  }
+ private:
+  class CountedStream : public RecordStream {
+   public:
+    CountedStream(RecordStream &records, Measurements *measurements)
+        : records_(records), measurements_(measurements) {}
+    bool Next(std::string *key, std::vector<Field> *values) {
+      if (!records_.Next(key, values)) {
+        return false;
+      }
+      measurements_->ReportUntimed(INSERT);
+      return true;
+    }
+   private:
+    RecordStream &records_;
+    Measurements *measurements_;
+  };
+
+  static uint64_t NowNs() {
+    return utils::TscClock::now().time_since_epoch().count();
+  }
+
+  ///
+  /// Runs call, timing one in sample_rate_ of them and only counting the rest.
+  /// With a flight recorder every call is timed and recorded.
+  ///
+  template <class Call>
+  Status Measure(Operation op, Operation failed_op, std::string_view key, const Call &call) {
+    if (StageBreakdown::Enabled()) {
+      return MeasureStages(op, failed_op, call);
+    }
+    if (--sample_countdown_ != 0 && recorder_ == nullptr) {
+      Status s = call();
+      measurements_->ReportUntimed(s == kOK ? op : failed_op);
+      return s;
+    }
+    sample_countdown_ = sample_rate_;
+    const uint64_t start = NowNs();
+    Status s = call();
+    uint64_t elapsed = NowNs() - start;
+    Operation reported = s == kOK ? op : failed_op;
+    measurements_->Report(reported, elapsed);
+    if (recorder_ != nullptr) {
+      recorder_->Record(reported, s, key, start, elapsed);
     }
     return s;
   }
-  Status Delete(const std::string &table, const std::string &key) {
+
+  ///
+  /// Wraps done to report an async op, timed from submit to completion for one
+  /// in sample_rate_ ops like Measure.
+  ///
+  Completion MeasureAsync(Operation op, Operation failed_op, std::string_view key,
+                          Completion done) {
+    if (--sample_countdown_ != 0 && recorder_ == nullptr) {
+      return [this, op, failed_op, done](Status s) {
+        measurements_->ReportUntimed(s == kOK ? op : failed_op);
+        done(s);
+      };
+    }
+    sample_countdown_ = sample_rate_;
+    const uint64_t start = NowNs();
+    // the key must outlive the op anyway, so the completion can still hash it
+    return [this, op, failed_op, key, done, start](Status s) {
+      uint64_t elapsed = NowNs() - start;
+      Operation reported = s == kOK ? op : failed_op;
+      measurements_->Report(reported, elapsed);
+      if (recorder_ != nullptr) {
+        recorder_->Record(reported, s, key, start, elapsed);
+      }
+      done(s);
+    };
+  }
+
+  ///
+  /// Times every call, charging it to the engine stage minus the encode and
+  /// decode time the binding spent in the row codec, and the report to the
+  /// record stage.
+  ///
+  template <class Call>
+  Status MeasureStages(Operation op, Operation failed_op, const Call &call) {
+    const uint64_t codec = StageBreakdown::Accumulated(STAGE_ENCODE) +
+                           StageBreakdown::Accumulated(STAGE_DECODE);
     timer_.Start();
-    Status s = db_->Delete(table, key);
+    Status s = call();
     uint64_t elapsed = timer_.End();
-    if (s == kOK) {
-      measurements_->Report(DELETE, elapsed);
-    } else {
-      measurements_->Report(DELETE_FAILED, elapsed);
-    }
+    const uint64_t codec_in_call = StageBreakdown::Accumulated(STAGE_ENCODE) +
+                                   StageBreakdown::Accumulated(STAGE_DECODE) - codec;
+    StageBreakdown::Add(STAGE_ENGINE, elapsed > codec_in_call ? elapsed - codec_in_call : 0);
+    ScopedStage record(STAGE_RECORD);
+    measurements_->Report(s == kOK ? op : failed_op, elapsed);
     return s;
   }
- private:
-  DB *db_;
+
+  Engine *db_;
   Measurements *measurements_;
+  FlightRecorder *recorder_; // nullptr unless flightrecorder.threshold_us is set
   utils::Timer<uint64_t, std::nano> timer_;
+  const int sample_rate_;
+  int sample_countdown_;
 };
 
 } // ycsbc
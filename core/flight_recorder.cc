@@ -0,0 +1,171 @@
+//
+//  flight_recorder.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#include "flight_recorder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <tuple>
+
+#include "timer.h"
+#include "utils.h"
+
+namespace {
+  const std::string PROP_THRESHOLD = "flightrecorder.threshold_us";
+  const std::string PROP_THRESHOLD_DEFAULT = "0";
+
+  const std::string PROP_SIZE = "flightrecorder.size";
+  const std::string PROP_SIZE_DEFAULT = "4096";
+
+  const std::string PROP_FILE = "flightrecorder.file";
+  const std::string PROP_FILE_DEFAULT = "ycsb-flight.bin";
+
+  bool StartsBefore(const ycsbc::FlightRecord &a, const ycsbc::FlightRecord &b) {
+    return std::tie(a.start_ns, a.thread, a.op, a.key_hash) <
+           std::tie(b.start_ns, b.thread, b.op, b.key_hash);
+  }
+
+  bool SameOp(const ycsbc::FlightRecord &a, const ycsbc::FlightRecord &b) {
+    return a.start_ns == b.start_ns && a.thread == b.thread && a.op == b.op &&
+           a.key_hash == b.key_hash;
+  }
+} // anonymous
+
+namespace ycsbc {
+
+const char kFlightDumpMagic[8] = {'Y', 'C', 'S', 'B', 'F', 'L', 'T', '1'};
+
+std::atomic<uint32_t> FlightRecorder::thread_count_{0};
+std::mutex FlightRecorder::file_mu_;
+
+FlightRecorder *FlightRecorder::Create(const utils::Properties &props) {
+  uint64_t threshold_us = std::stoull(props.GetProperty(PROP_THRESHOLD, PROP_THRESHOLD_DEFAULT));
+  if (threshold_us == 0) {
+    return nullptr;
+  }
+  size_t size = std::stoul(props.GetProperty(PROP_SIZE, PROP_SIZE_DEFAULT));
+  if (size < 2) {
+    throw utils::Exception(PROP_SIZE + " must be at least 2");
+  }
+  const std::string path = props.GetProperty(PROP_FILE, PROP_FILE_DEFAULT);
+
+  // the first recorder of the run starts a fresh file
+  static std::once_flag truncated;
+  std::call_once(truncated, [&path] {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+      throw utils::Exception("Cannot create " + path + ": " + strerror(errno));
+    }
+    fclose(file);
+  });
+  return new FlightRecorder(path, size, threshold_us * 1000);
+}
+
+FlightRecorder::FlightRecorder(const std::string &path, size_t capacity, uint64_t threshold_ns)
+    : path_(path), threshold_ns_(threshold_ns), thread_(thread_count_++), ring_(capacity),
+      next_(0), size_(0), dump_countdown_(0) {}
+
+FlightRecorder::~FlightRecorder() {
+  if (dump_countdown_ != 0) {
+    try {
+      Dump();
+    } catch (const utils::Exception &e) {
+      fprintf(stderr, "%s\n", e.what());
+    }
+  }
+}
+
+void FlightRecorder::Record(uint8_t op, uint8_t status, std::string_view key, uint64_t start_ns,
+                            uint64_t latency_ns) {
+  FlightRecord &record = ring_[next_];
+  record.start_ns = start_ns;
+  record.latency_ns = latency_ns;
+  record.key_hash = std::hash<std::string_view>()(key);
+  record.thread = thread_;
+  record.op = op;
+  record.status = status;
+  record.reserved = 0;
+  next_ = (next_ + 1) % ring_.size();
+  if (size_ < ring_.size()) {
+    size_++;
+  }
+
+  // an outlier while a window is pending is covered by that window
+  if (dump_countdown_ != 0) {
+    if (--dump_countdown_ == 0) {
+      Dump();
+    }
+  } else if (latency_ns > threshold_ns_) {
+    dump_countdown_ = ring_.size() / 2;
+  }
+}
+
+void FlightRecorder::Dump() {
+  dump_countdown_ = 0;
+  FlightDumpHeader header;
+  memcpy(header.magic, kFlightDumpMagic, sizeof(header.magic));
+  header.thread = thread_;
+  header.count = size_;
+  header.threshold_ns = threshold_ns_;
+  header.clock_ns = utils::TscClock::now().time_since_epoch().count();
+  header.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  std::lock_guard<std::mutex> lock(file_mu_);
+  FILE *file = fopen(path_.c_str(), "ab");
+  if (file == nullptr) {
+    throw utils::Exception("Cannot open " + path_ + ": " + strerror(errno));
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  // oldest first: once the ring has wrapped, the part from next_ on is older
+  if (size_ == ring_.size()) {
+    const size_t older = ring_.size() - next_;
+    ok = ok && fwrite(&ring_[next_], sizeof(FlightRecord), older, file) == older;
+  }
+  ok = ok && fwrite(ring_.data(), sizeof(FlightRecord), next_, file) == next_;
+  fclose(file);
+  if (!ok) {
+    throw utils::Exception("Cannot write " + path_);
+  }
+}
+
+size_t ReadFlightDump(const std::string &path, std::vector<FlightRecord> *records,
+                      FlightDumpHeader *last) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    throw utils::Exception("Cannot open " + path + ": " + strerror(errno));
+  }
+  size_t windows = 0;
+  FlightDumpHeader header;
+  while (fread(&header, sizeof(header), 1, file) == 1) {
+    if (memcmp(header.magic, kFlightDumpMagic, sizeof(header.magic)) != 0) {
+      fclose(file);
+      throw utils::Exception(path + ": bad window header after " + std::to_string(windows) +
+                             " windows");
+    }
+    size_t base = records->size();
+    records->resize(base + header.count);
+    if (fread(&(*records)[base], sizeof(FlightRecord), header.count, file) != header.count) {
+      fclose(file);
+      throw utils::Exception(path + ": truncated window " + std::to_string(windows));
+    }
+    *last = header;
+    windows++;
+  }
+  fclose(file);
+
+  // windows of one thread overlap when outliers follow each other closely
+  std::sort(records->begin(), records->end(), StartsBefore);
+  records->erase(std::unique(records->begin(), records->end(), SameOp), records->end());
+  return windows;
+}
+
+} // ycsbc
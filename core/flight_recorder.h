@@ -0,0 +1,95 @@
+//
+//  flight_recorder.h
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#ifndef YCSB_C_FLIGHT_RECORDER_H_
+#define YCSB_C_FLIGHT_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "properties.h"
+
+namespace ycsbc {
+
+///
+/// One op as kept by the flight recorder and written to its dump file.
+///
+struct FlightRecord {
+  uint64_t start_ns;   // TscClock time the op was issued
+  uint64_t latency_ns;
+  uint64_t key_hash;
+  uint32_t thread;
+  uint8_t op;          // Operation, *_FAILED when the op failed
+  uint8_t status;      // DB::Status
+  uint16_t reserved;
+};
+
+///
+/// Precedes each window in the dump file, followed by count records, oldest
+/// first. The clock/wall pair maps record timestamps to wall-clock time.
+///
+struct FlightDumpHeader {
+  char magic[8];
+  uint32_t thread;
+  uint32_t count;
+  uint64_t threshold_ns;
+  uint64_t clock_ns;   // TscClock time of the dump
+  uint64_t wall_ns;    // system_clock time of the dump, ns since the epoch
+};
+
+extern const char kFlightDumpMagic[8];
+
+///
+/// Reads every window of a dump file into records, ordered by start time, with
+/// the ops shared by overlapping windows of a thread kept once. last receives
+/// the header of the last window. Throws utils::Exception on a malformed file.
+/// @return The number of windows read.
+///
+size_t ReadFlightDump(const std::string &path, std::vector<FlightRecord> *records,
+                      FlightDumpHeader *last);
+
+///
+/// Ring buffer of the most recent ops of one client thread. When an op takes
+/// longer than the threshold, the ring is appended to the dump file once half
+/// a ring of later ops has been recorded, so the window surrounds the outlier.
+///
+class FlightRecorder {
+ public:
+  ///
+  /// Creates a recorder from the flightrecorder.* properties, or returns
+  /// nullptr when flightrecorder.threshold_us is 0.
+  ///
+  static FlightRecorder *Create(const utils::Properties &props);
+
+  FlightRecorder(const std::string &path, size_t capacity, uint64_t threshold_ns);
+  ~FlightRecorder();
+
+  void Record(uint8_t op, uint8_t status, std::string_view key, uint64_t start_ns,
+              uint64_t latency_ns);
+
+ private:
+  void Dump();
+
+  const std::string path_;
+  const uint64_t threshold_ns_;
+  const uint32_t thread_;
+  std::vector<FlightRecord> ring_;
+  size_t next_;
+  size_t size_;
+  size_t dump_countdown_; // ops until the pending window is written, 0 if none
+
+  static std::atomic<uint32_t> thread_count_;
+  static std::mutex file_mu_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_FLIGHT_RECORDER_H_
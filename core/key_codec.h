@@ -0,0 +1,112 @@
+//
+//  key_codec.h
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#ifndef YCSB_C_KEY_CODEC_H_
+#define YCSB_C_KEY_CODEC_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "utils.h"
+
+namespace ycsbc {
+
+///
+/// How a key number is turned into the key bytes handed to the bindings.
+/// All encodings but kKeyNative sort lexicographically in numeric order.
+///
+enum KeyEncoding {
+  kKeyDecimal,    // "user" + zero padded decimal digits
+  kKeyBigEndian,  // 8 bytes, most significant byte first
+  kKeyNative,     // 8 bytes, host byte order (legacy fixedkey8b layout)
+  kKeyVarint      // 1 byte length + minimal big-endian bytes
+};
+
+inline KeyEncoding ParseKeyEncoding(const std::string &name) {
+  if (name == "decimal") {
+    return kKeyDecimal;
+  } else if (name == "bigendian") {
+    return kKeyBigEndian;
+  } else if (name == "native") {
+    return kKeyNative;
+  } else if (name == "varint") {
+    return kKeyVarint;
+  }
+  throw utils::Exception("Unknown key encoding: " + name);
+}
+
+///
+/// Appends the binary encoding of key_num. kKeyDecimal is built by the workload
+/// since it depends on the zero padding setting.
+///
+inline void EncodeKeyNum(uint64_t key_num, KeyEncoding encoding, std::string *key) {
+  char buf[9];
+  switch (encoding) {
+    case kKeyBigEndian:
+      for (int i = 7; i >= 0; i--) {
+        buf[i] = static_cast<char>(key_num & 0xff);
+        key_num >>= 8;
+      }
+      key->append(buf, 8);
+      break;
+    case kKeyNative:
+      memcpy(buf, &key_num, sizeof(key_num));
+      key->append(buf, 8);
+      break;
+    case kKeyVarint: {
+      int n = 1;
+      while (n < 8 && (key_num >> (8 * n)) != 0) {
+        n++;
+      }
+      buf[0] = static_cast<char>(n);
+      for (int i = n; i >= 1; i--) {
+        buf[i] = static_cast<char>(key_num & 0xff);
+        key_num >>= 8;
+      }
+      key->append(buf, n + 1);
+      break;
+    }
+    default:
+      throw utils::Exception("EncodeKeyNum: not a binary key encoding");
+  }
+}
+
+///
+/// Recovers the key number from key bytes, e.g. for integer-keyed engines.
+///
+inline uint64_t DecodeKeyNum(const char *data, size_t size, KeyEncoding encoding) {
+  uint64_t key_num = 0;
+  switch (encoding) {
+    case kKeyDecimal:
+      for (size_t i = 0; i < size; i++) {
+        if (data[i] >= '0' && data[i] <= '9') {
+          key_num = key_num * 10 + (data[i] - '0');
+        }
+      }
+      break;
+    case kKeyBigEndian:
+      for (size_t i = 0; i < 8 && i < size; i++) {
+        key_num = (key_num << 8) | static_cast<uint8_t>(data[i]);
+      }
+      break;
+    case kKeyNative:
+      memcpy(&key_num, data, std::min<size_t>(size, sizeof(key_num)));
+      break;
+    case kKeyVarint:
+      for (size_t i = 1; i <= static_cast<uint8_t>(data[0]) && i < size; i++) {
+        key_num = (key_num << 8) | static_cast<uint8_t>(data[i]);
+      }
+      break;
+  }
+  return key_num;
+}
+
+} // ycsbc
+
+#endif // YCSB_C_KEY_CODEC_H_
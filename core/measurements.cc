@@ -6,6 +6,8 @@
 //
 
 #include "measurements.h"
+#include "stage_breakdown.h"
+#include "timer.h"
 #include "utils.h"
 
 #include <limits>
@@ -19,11 +21,21 @@ namespace {
 #else
   const std::string MEASUREMENT_TYPE_DEFAULT = "basic";
 #endif
+
+  const std::string MEASUREMENT_SAMPLE_RATE = "measurement.sample_rate";
+  const std::string MEASUREMENT_SAMPLE_RATE_DEFAULT = "1";
+
+  const std::string MEASUREMENT_CLOCK = "measurement.clock";
+  const std::string MEASUREMENT_CLOCK_DEFAULT = "tsc";
+
+  const std::string MEASUREMENT_BREAKDOWN = "measurement.breakdown";
+  const std::string MEASUREMENT_BREAKDOWN_DEFAULT = "false";
 } // anonymous
 
 namespace ycsbc {
 
-BasicMeasurements::BasicMeasurements() : count_{}, latency_sum_{}, latency_max_{} {
+BasicMeasurements::BasicMeasurements()
+    : count_{}, untimed_count_{}, latency_sum_{}, latency_max_{} {
   std::fill(std::begin(latency_min_), std::end(latency_min_), std::numeric_limits<uint64_t>::max());
 }
 
@@ -38,6 +50,10 @@ void BasicMeasurements::Report(Operation op, uint64_t latency) {
          && !latency_max_[op].compare_exchange_weak(prev_max, latency, std::memory_order_relaxed));
 }
 
+void BasicMeasurements::ReportUntimed(Operation op) {
+  untimed_count_[op].fetch_add(1, std::memory_order_relaxed);
+}
+
 std::string BasicMeasurements::GetStatusMsg() {
   std::ostringstream msg_stream;
   msg_stream.precision(2);
@@ -46,31 +62,33 @@ std::string BasicMeasurements::GetStatusMsg() {
   for (int i = 0; i < MAXOPTYPE; i++) {
     Operation op = static_cast<Operation>(i);
     uint64_t cnt = count_[op].load(std::memory_order_relaxed);
-    if (cnt == 0)
+    uint64_t untimed = untimed_count_[op].load(std::memory_order_relaxed);
+    if (cnt + untimed == 0)
       continue;
     msg_stream << " [" << kOperationString[op] << ":"
-               << " Count=" << cnt
+               << " Count=" << cnt + untimed
                << " Max=" << latency_max_[op].load(std::memory_order_relaxed) / 1000.0
-               << " Min=" << latency_min_[op].load(std::memory_order_relaxed) / 1000.0
+               << " Min=" << (cnt > 0 ? latency_min_[op].load(std::memory_order_relaxed) : 0) / 1000.0
                << " Avg="
                << ((cnt > 0)
                    ? static_cast<double>(latency_sum_[op].load(std::memory_order_relaxed)) / cnt
                    : 0) / 1000.0
                << "]";
-    total_cnt += cnt;
+    total_cnt += cnt + untimed;
   }
   return std::to_string(total_cnt) + msg_stream.str();
 }
 
 void BasicMeasurements::Reset() {
   std::fill(std::begin(count_), std::end(count_), 0);
+  std::fill(std::begin(untimed_count_), std::end(untimed_count_), 0);
   std::fill(std::begin(latency_sum_), std::end(latency_sum_), 0);
   std::fill(std::begin(latency_min_), std::end(latency_min_), std::numeric_limits<uint64_t>::max());
   std::fill(std::begin(latency_max_), std::end(latency_max_), 0);
 }
 
 #ifdef HDRMEASUREMENT
-HdrHistogramMeasurements::HdrHistogramMeasurements() {
+HdrHistogramMeasurements::HdrHistogramMeasurements() : untimed_count_{} {
   for (int op = 0; op < MAXOPTYPE; op++) {
     if (hdr_init(10, 100LL * 1000 * 1000 * 1000, 3, &histogram_[op]) != 0) {
       utils::Exception("hdr init failed");
@@ -82,6 +100,10 @@ void HdrHistogramMeasurements::Report(Operation op, uint64_t latency) {
   hdr_record_value_atomic(histogram_[op], latency);
 }
 
+void HdrHistogramMeasurements::ReportUntimed(Operation op) {
+  untimed_count_[op].fetch_add(1, std::memory_order_relaxed);
+}
+
 std::string HdrHistogramMeasurements::GetStatusMsg() {
   std::ostringstream msg_stream;
   msg_stream.precision(2);
@@ -90,10 +112,11 @@ std::string HdrHistogramMeasurements::GetStatusMsg() {
   for (int i = 0; i < MAXOPTYPE; i++) {
     Operation op = static_cast<Operation>(i);
     uint64_t cnt = histogram_[op]->total_count;
-    if (cnt == 0)
+    uint64_t untimed = untimed_count_[op].load(std::memory_order_relaxed);
+    if (cnt + untimed == 0)
       continue;
     msg_stream << " [" << kOperationString[op] << ":"
-               << " Count=" << cnt
+               << " Count=" << cnt + untimed
                << " Max=" << hdr_max(histogram_[op]) / 1000.0
                << " Min=" << hdr_min(histogram_[op]) / 1000.0
                << " Avg=" << hdr_mean(histogram_[op]) / 1000.0
@@ -102,7 +125,7 @@ std::string HdrHistogramMeasurements::GetStatusMsg() {
                << " 99.9=" << hdr_value_at_percentile(histogram_[op], 99.9) / 1000.0
                << " 99.99=" << hdr_value_at_percentile(histogram_[op], 99.99) / 1000.0
                << "]";
-    total_cnt += cnt;
+    total_cnt += cnt + untimed;
   }
   return std::to_string(total_cnt) + msg_stream.str();
 }
@@ -111,6 +134,7 @@ void HdrHistogramMeasurements::Reset() {
   for (int op = 0; op < MAXOPTYPE; op++) {
     hdr_reset(histogram_[op]);
   }
+  std::fill(std::begin(untimed_count_), std::end(untimed_count_), 0);
 }
 #endif
 
@@ -125,8 +149,25 @@ Measurements *CreateMeasurements(utils::Properties *props) {
     measurements = new HdrHistogramMeasurements();
 #endif
   } else {
-    measurements = nullptr;
+    return nullptr;
+  }
+
+  int sample_rate = std::stoi(props->GetProperty(MEASUREMENT_SAMPLE_RATE,
+                                                 MEASUREMENT_SAMPLE_RATE_DEFAULT));
+  if (sample_rate < 1) {
+    throw utils::Exception(MEASUREMENT_SAMPLE_RATE + " must be at least 1");
   }
+  measurements->SetSampleRate(sample_rate);
+
+  const std::string clock = props->GetProperty(MEASUREMENT_CLOCK, MEASUREMENT_CLOCK_DEFAULT);
+  if (clock == "monotonic") {
+    utils::TscClock::Calibrate(true);
+  } else if (clock != "tsc") {
+    throw utils::Exception("Unknown " + MEASUREMENT_CLOCK + ": " + clock);
+  }
+
+  StageBreakdown::SetEnabled(utils::StrToBool(props->GetProperty(MEASUREMENT_BREAKDOWN,
+                                                                 MEASUREMENT_BREAKDOWN_DEFAULT)));
 
   return measurements;
 }
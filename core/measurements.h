@@ -23,19 +23,35 @@ namespace ycsbc {
 
 class Measurements {
  public:
+  Measurements() : sample_rate_(1) {}
   virtual void Report(Operation op, uint64_t latency) = 0;
+  ///
+  /// Counts an operation that was not timed, see sample_rate().
+  ///
+  virtual void ReportUntimed(Operation op) = 0;
   virtual std::string GetStatusMsg() = 0;
   virtual void Reset() = 0;
+
+  ///
+  /// Only one in sample_rate operations is timed; the others are counted
+  /// through ReportUntimed, and latency statistics cover the timed ones.
+  ///
+  int sample_rate() const { return sample_rate_; }
+  void SetSampleRate(int sample_rate) { sample_rate_ = sample_rate; }
+ private:
+  int sample_rate_;
 };
 
 class BasicMeasurements : public Measurements {
  public:
   BasicMeasurements();
   void Report(Operation op, uint64_t latency) override;
+  void ReportUntimed(Operation op) override;
   std::string GetStatusMsg() override;
   void Reset() override;
  private:
   std::atomic<uint> count_[MAXOPTYPE];
+  std::atomic<uint> untimed_count_[MAXOPTYPE];
   std::atomic<uint64_t> latency_sum_[MAXOPTYPE];
   std::atomic<uint64_t> latency_min_[MAXOPTYPE];
   std::atomic<uint64_t> latency_max_[MAXOPTYPE];
@@ -46,10 +62,12 @@ class HdrHistogramMeasurements : public Measurements {
  public:
   HdrHistogramMeasurements();
   void Report(Operation op, uint64_t latency) override;
+  void ReportUntimed(Operation op) override;
   std::string GetStatusMsg() override;
   void Reset() override;
  private:
   hdr_histogram *histogram_[MAXOPTYPE];
+  std::atomic<uint64_t> untimed_count_[MAXOPTYPE];
 };
 #endif
 
@@ -0,0 +1,327 @@
+//
+//  row_codec.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#include "row_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "core_workload.h"
+#include "stage_breakdown.h"
+#include "utils.h"
+
+namespace {
+
+inline uint32_t LoadU32(const char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline void AppendU32(std::string *data, uint32_t v) {
+  data->append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+// Parses the length-prefixed entry at p, returning the end of the entry or
+// nullptr if it runs past lim.
+inline const char *ParseEntry(const char *p, const char *lim, ycsbc::DB::FieldView *field) {
+  if (lim - p < static_cast<ptrdiff_t>(sizeof(uint32_t))) {
+    return nullptr;
+  }
+  uint32_t len = LoadU32(p);
+  p += sizeof(uint32_t);
+  if (lim - p < static_cast<ptrdiff_t>(len + sizeof(uint32_t))) {
+    return nullptr;
+  }
+  field->name = std::string_view(p, len);
+  p += len;
+  len = LoadU32(p);
+  p += sizeof(uint32_t);
+  if (lim - p < static_cast<ptrdiff_t>(len)) {
+    return nullptr;
+  }
+  field->value = std::string_view(p, len);
+  return p + len;
+}
+
+// Views left value-initialized by Project mark fields the row does not have.
+inline bool IsUnresolved(const ycsbc::DB::FieldView &field) {
+  return field.name.data() == nullptr;
+}
+
+// Stores field into every unresolved slot whose name it carries, so a name
+// requested twice resolves twice as it does through the slot lookups. Names
+// are compared by length before their bytes, so a miss costs one integer
+// compare per requested field. Returns the number of slots filled.
+inline size_t Match(const ycsbc::DB::FieldView &field, const std::vector<std::string> &fields,
+                    ycsbc::DB::FieldView *out) {
+  size_t matched = 0;
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (IsUnresolved(out[i]) && fields[i].size() == field.name.size() &&
+        memcmp(fields[i].data(), field.name.data(), field.name.size()) == 0) {
+      out[i] = field;
+      matched++;
+    }
+  }
+  return matched;
+}
+
+// Projections up to this many fields resolve without a heap allocation.
+constexpr size_t kMaxLocalFields = 16;
+
+struct IndexedRow {
+  uint32_t count = 0;
+  const char *offsets = nullptr;
+  const char *body = nullptr;
+  size_t body_size = 0;
+
+  explicit IndexedRow(std::string_view data) {
+    if (data.size() < sizeof(uint32_t)) {
+      return;
+    }
+    uint32_t n = LoadU32(data.data());
+    size_t header = sizeof(uint32_t) * (static_cast<size_t>(n) + 1);
+    if (header > data.size()) {
+      return;
+    }
+    count = n;
+    offsets = data.data() + sizeof(uint32_t);
+    body = data.data() + header;
+    body_size = data.size() - header;
+  }
+
+  bool Field(uint32_t i, ycsbc::DB::FieldView *field) const {
+    size_t begin = LoadU32(offsets + i * sizeof(uint32_t));
+    size_t end = i + 1 < count ? LoadU32(offsets + (i + 1) * sizeof(uint32_t)) : body_size;
+    if (begin + sizeof(uint32_t) > end || end > body_size) {
+      return false;
+    }
+    uint32_t name_len = LoadU32(body + begin);
+    begin += sizeof(uint32_t);
+    if (begin + name_len > end) {
+      return false;
+    }
+    field->name = std::string_view(body + begin, name_len);
+    field->value = std::string_view(body + begin + name_len, end - begin - name_len);
+    return true;
+  }
+};
+
+} // anonymous
+
+namespace ycsbc {
+
+const std::string RowCodec::FORMAT_PROPERTY = "rowformat";
+const std::string RowCodec::FORMAT_DEFAULT = "auto";
+
+RowCodec RowCodec::FromProperties(const utils::Properties &p) {
+  const std::string prefix = p.GetProperty(CoreWorkload::FIELD_NAME_PREFIX,
+                                           CoreWorkload::FIELD_NAME_PREFIX_DEFAULT);
+  const bool fixed_len = utils::StrToBool(p.GetProperty(CoreWorkload::FIXED_FIELD_LEN,
+                                                        CoreWorkload::FIXED_FIELD_LEN_DEFAULT));
+  const size_t slot = std::stoul(p.GetProperty(CoreWorkload::FIELD_LENGTH_PROPERTY,
+                                               CoreWorkload::FIELD_LENGTH_DEFAULT));
+  const std::string format = p.GetProperty(FORMAT_PROPERTY, FORMAT_DEFAULT);
+  if (format == "auto") {
+    return RowCodec(fixed_len ? kFixedSlot : kLengthPrefixed, prefix, slot);
+  } else if (format == "lengthprefixed") {
+    return RowCodec(kLengthPrefixed, prefix, slot);
+  } else if (format == "indexed") {
+    return RowCodec(kOffsetIndexed, prefix, slot);
+  } else if (format == "fixedslot") {
+    if (!fixed_len) {
+      throw utils::Exception("rowformat=fixedslot requires " + CoreWorkload::FIXED_FIELD_LEN);
+    }
+    return RowCodec(kFixedSlot, prefix, slot);
+  }
+  throw utils::Exception("Unknown row format: " + format);
+}
+
+void RowCodec::Encode(const std::vector<DB::Field> &values, std::string *data) const {
+  ScopedStage stage(STAGE_ENCODE);
+  if (format_ != kOffsetIndexed) {
+    size_t size = data->size();
+    for (const DB::Field &field : values) {
+      size += 2 * sizeof(uint32_t) + field.name.size() + field.value.size();
+    }
+    data->reserve(size);
+    for (const DB::Field &field : values) {
+      AppendU32(data, field.name.size());
+      data->append(field.name);
+      AppendU32(data, field.value.size());
+      data->append(field.value);
+    }
+    return;
+  }
+
+  size_t header = sizeof(uint32_t) * (values.size() + 1);
+  size_t size = data->size() + header;
+  for (const DB::Field &field : values) {
+    size += sizeof(uint32_t) + field.name.size() + field.value.size();
+  }
+  data->reserve(size);
+  const size_t header_pos = data->size();
+  AppendU32(data, values.size());
+  data->append(values.size() * sizeof(uint32_t), '\0');
+  const size_t body_pos = data->size();
+  for (size_t i = 0; i < values.size(); i++) {
+    uint32_t offset = data->size() - body_pos;
+    memcpy(&(*data)[header_pos + (i + 1) * sizeof(uint32_t)], &offset, sizeof(offset));
+    AppendU32(data, values[i].name.size());
+    data->append(values[i].name);
+    data->append(values[i].value);
+  }
+}
+
+void RowCodec::Decode(std::string_view data, std::vector<DB::FieldView> *values) const {
+  ScopedStage stage(STAGE_DECODE);
+  DB::FieldView field;
+  if (format_ == kOffsetIndexed) {
+    IndexedRow row(data);
+    values->reserve(values->size() + row.count);
+    for (uint32_t i = 0; i < row.count; i++) {
+      if (!row.Field(i, &field)) {
+        throw utils::Exception("RowCodec: corrupted row");
+      }
+      values->push_back(field);
+    }
+    return;
+  }
+  const char *p = data.data();
+  const char *lim = p + data.size();
+  while (p != lim) {
+    p = ParseEntry(p, lim, &field);
+    if (p == nullptr) {
+      throw utils::Exception("RowCodec: corrupted row");
+    }
+    values->push_back(field);
+  }
+}
+
+void RowCodec::Decode(std::string_view data, std::vector<DB::Field> *values) const {
+  std::vector<DB::FieldView> views;
+  Decode(data, &views);
+  ScopedStage stage(STAGE_DECODE);
+  values->reserve(values->size() + views.size());
+  for (const DB::FieldView &view : views) {
+    values->push_back({std::string(view.name), std::string(view.value)});
+  }
+}
+
+void RowCodec::DecodeFilter(std::string_view data, const std::vector<std::string> &fields,
+                            std::vector<DB::FieldView> *values) const {
+  ScopedStage stage(STAGE_DECODE);
+  const size_t base = values->size();
+  values->resize(base + fields.size());
+  if (Project(data, fields, values->data() + base) < fields.size()) {
+    values->erase(std::remove_if(values->begin() + base, values->end(), IsUnresolved),
+                  values->end());
+  }
+}
+
+void RowCodec::DecodeFilter(std::string_view data, const std::vector<std::string> &fields,
+                            std::vector<DB::Field> *values) const {
+  ScopedStage stage(STAGE_DECODE);
+  DB::FieldView local[kMaxLocalFields];
+  std::vector<DB::FieldView> heap;
+  DB::FieldView *views = local;
+  if (fields.size() > kMaxLocalFields) {
+    heap.resize(fields.size());
+    views = heap.data();
+  }
+  Project(data, fields, views);
+  values->reserve(values->size() + fields.size());
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (!IsUnresolved(views[i])) {
+      values->push_back({std::string(views[i].name), std::string(views[i].value)});
+    }
+  }
+}
+
+// Resolves fields[i] into out[i], which the caller passes value-initialized.
+// Returns the number of fields found.
+size_t RowCodec::Project(std::string_view data, const std::vector<std::string> &fields,
+                         DB::FieldView *out) const {
+  if (format_ == kLengthPrefixed || (format_ == kFixedSlot && slot_size_ == 0)) {
+    return ProjectSequential(data, fields, out, fields.size());
+  }
+
+  size_t found = 0;
+  if (format_ == kOffsetIndexed) {
+    IndexedRow row(data);
+    for (size_t i = 0; i < fields.size(); i++) {
+      int index = FieldIndex(fields[i]);
+      if (index >= 0 && static_cast<uint32_t>(index) < row.count &&
+          row.Field(index, &out[i]) && out[i].name == fields[i]) {
+        found++;
+      } else {
+        out[i] = DB::FieldView();
+      }
+    }
+    if (found == fields.size()) {
+      return found;
+    }
+    // names outside the prefix + index scheme
+    DB::FieldView field;
+    for (uint32_t j = 0; j < row.count && found < fields.size(); j++) {
+      if (!row.Field(j, &field)) {
+        break;
+      }
+      found += Match(field, fields, out);
+    }
+    return found;
+  }
+
+  for (size_t i = 0; i < fields.size(); i++) {
+    int index = FieldIndex(fields[i]);
+    size_t offset = static_cast<size_t>(index) * slot_size_;
+    if (index >= 0 && offset + slot_size_ <= data.size()) {
+      const char *p = data.data() + offset;
+      if (ParseEntry(p, p + slot_size_, &out[i]) != nullptr && out[i].name == fields[i]) {
+        found++;
+        continue;
+      }
+    }
+    out[i] = DB::FieldView();
+  }
+  // rows written with other field lengths still decode, just not in O(1)
+  return found == fields.size() ? found
+                                : found + ProjectSequential(data, fields, out, fields.size() - found);
+}
+
+size_t RowCodec::ProjectSequential(std::string_view data, const std::vector<std::string> &fields,
+                                   DB::FieldView *out, size_t remaining) const {
+  size_t found = 0;
+  DB::FieldView field;
+  const char *p = data.data();
+  const char *lim = p + data.size();
+  while (found < remaining && p != lim) {
+    p = ParseEntry(p, lim, &field);
+    if (p == nullptr) {
+      break;
+    }
+    found += Match(field, fields, out);
+  }
+  return found;
+}
+
+// Field names generated by the workload are prefix + index; returns -1 for other names.
+int RowCodec::FieldIndex(std::string_view name) const {
+  if (name.size() <= field_prefix_.size() || name.compare(0, field_prefix_.size(), field_prefix_)) {
+    return -1;
+  }
+  int index = 0;
+  for (size_t i = field_prefix_.size(); i < name.size(); i++) {
+    if (name[i] < '0' || name[i] > '9' || index > (1 << 20)) {
+      return -1;
+    }
+    index = index * 10 + (name[i] - '0');
+  }
+  return index;
+}
+
+} // ycsbc
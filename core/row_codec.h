@@ -0,0 +1,91 @@
+//
+//  row_codec.h
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#ifndef YCSB_C_ROW_CODEC_H_
+#define YCSB_C_ROW_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "db.h"
+#include "properties.h"
+
+namespace ycsbc {
+
+///
+/// Encodes the fields of a record into the value stored by the bindings.
+///
+/// kLengthPrefixed: [4B name len][name][4B value len][value] per field, the
+///   layout every binding used so far.
+/// kOffsetIndexed: [4B field count][4B body offset per field] followed by
+///   [4B name len][name][value] per field, so any field is one lookup away.
+/// kFixedSlot: kLengthPrefixed bytes, but with fixedfieldlen=true every field
+///   occupies exactly fieldlength bytes, so field i is read at i * fieldlength
+///   without walking the fields before it.
+///
+/// Decoding yields views into the encoded bytes; the Field overloads copy
+/// each name and value once.
+///
+class RowCodec {
+ public:
+  enum Format {
+    kLengthPrefixed,
+    kOffsetIndexed,
+    kFixedSlot
+  };
+
+  ///
+  /// The name of the property for the row format.
+  /// Options are "auto" (fixedslot with fixedfieldlen=true, lengthprefixed
+  /// otherwise), "lengthprefixed", "indexed" and "fixedslot".
+  ///
+  static const std::string FORMAT_PROPERTY;
+  static const std::string FORMAT_DEFAULT;
+
+  RowCodec() : format_(kLengthPrefixed), slot_size_(0) {}
+  RowCodec(Format format, const std::string &field_prefix, size_t slot_size)
+      : format_(format), field_prefix_(field_prefix), slot_size_(slot_size) {}
+
+  static RowCodec FromProperties(const utils::Properties &p);
+
+  Format format() const { return format_; }
+
+  void Encode(const std::vector<DB::Field> &values, std::string *data) const;
+
+  void Decode(std::string_view data, std::vector<DB::FieldView> *values) const;
+  void Decode(std::string_view data, std::vector<DB::Field> *values) const;
+
+  ///
+  /// Decodes only the requested fields, in the order they are requested,
+  /// with one entry per request in every format, so a name requested twice
+  /// appears twice. Fields missing from the row are skipped. All requested
+  /// fields are resolved in one pass; non-matching fields are skipped without
+  /// copying.
+  ///
+  void DecodeFilter(std::string_view data, const std::vector<std::string> &fields,
+                    std::vector<DB::FieldView> *values) const;
+  void DecodeFilter(std::string_view data, const std::vector<std::string> &fields,
+                    std::vector<DB::Field> *values) const;
+
+ private:
+  size_t Project(std::string_view data, const std::vector<std::string> &fields,
+                 DB::FieldView *out) const;
+  size_t ProjectSequential(std::string_view data, const std::vector<std::string> &fields,
+                           DB::FieldView *out, size_t remaining) const;
+  int FieldIndex(std::string_view name) const;
+
+  Format format_;
+  std::string field_prefix_;
+  size_t slot_size_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_ROW_CODEC_H_
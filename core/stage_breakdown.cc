@@ -0,0 +1,137 @@
+//
+//  stage_breakdown.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#include "stage_breakdown.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+// log2 buckets: bucket 0 holds 0, bucket b > 0 holds [2^(b-1), 2^b)
+constexpr int kBuckets = 65;
+
+struct Histogram {
+  uint64_t buckets[kBuckets] = {};
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t max = 0;
+
+  void Record(uint64_t ns) {
+    buckets[ns == 0 ? 0 : 64 - __builtin_clzll(ns)]++;
+    count++;
+    sum += ns;
+    max = std::max(max, ns);
+  }
+
+  void Merge(const Histogram &other) {
+    for (int b = 0; b < kBuckets; b++) {
+      buckets[b] += other.buckets[b];
+    }
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+  }
+
+  // upper bound of the bucket holding the percentile
+  uint64_t Percentile(double p) const {
+    uint64_t target = static_cast<uint64_t>(count * p / 100.0);
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; b++) {
+      seen += buckets[b];
+      if (seen > target) {
+        return b == kBuckets - 1 ? max : std::min<uint64_t>(max, (1ull << b) - 1);
+      }
+    }
+    return max;
+  }
+};
+
+struct ThreadState {
+  uint64_t op_start = 0;
+  uint64_t op_stage[ycsbc::MAXSTAGE] = {};
+  Histogram histogram[ycsbc::MAXSTAGE];
+};
+
+thread_local ThreadState thread_state;
+
+std::mutex totals_mutex;
+Histogram totals[ycsbc::MAXSTAGE];
+
+} // anonymous
+
+namespace ycsbc {
+
+const char *kStageString[MAXSTAGE] = {
+  "GENERATE",
+  "ENCODE",
+  "ENGINE",
+  "DECODE",
+  "VERIFY",
+  "RECORD",
+};
+
+bool StageBreakdown::enabled_ = false;
+
+void StageBreakdown::Add(Stage stage, uint64_t ns) {
+  thread_state.op_stage[stage] += ns;
+}
+
+uint64_t StageBreakdown::Accumulated(Stage stage) {
+  return thread_state.op_stage[stage];
+}
+
+void StageBreakdown::BeginOp() {
+  ThreadState &state = thread_state;
+  std::fill(std::begin(state.op_stage), std::end(state.op_stage), 0);
+  state.op_start = Now();
+}
+
+void StageBreakdown::EndOp() {
+  ThreadState &state = thread_state;
+  uint64_t total = Now() - state.op_start;
+  uint64_t accounted = 0;
+  for (int s = STAGE_ENCODE; s < MAXSTAGE; s++) {
+    accounted += state.op_stage[s];
+  }
+  state.op_stage[STAGE_GENERATE] = total > accounted ? total - accounted : 0;
+  for (int s = 0; s < MAXSTAGE; s++) {
+    // stages an op does not go through (no encode on reads, ...) are not recorded
+    if (state.op_stage[s] != 0 || s == STAGE_GENERATE) {
+      state.histogram[s].Record(state.op_stage[s]);
+    }
+  }
+}
+
+void StageBreakdown::FlushThread() {
+  ThreadState &state = thread_state;
+  std::lock_guard<std::mutex> lock(totals_mutex);
+  for (int s = 0; s < MAXSTAGE; s++) {
+    totals[s].Merge(state.histogram[s]);
+    state.histogram[s] = Histogram();
+  }
+}
+
+void StageBreakdown::Report(std::ostream &out, const char *phase) {
+  std::lock_guard<std::mutex> lock(totals_mutex);
+  for (int s = 0; s < MAXSTAGE; s++) {
+    const Histogram &h = totals[s];
+    if (h.count == 0) {
+      continue;
+    }
+    out << phase << " stage " << kStageString[s] << ":"
+        << " Count=" << h.count
+        << " Avg=" << static_cast<double>(h.sum) / h.count / 1000.0
+        << " 50<=" << h.Percentile(50) / 1000.0
+        << " 99<=" << h.Percentile(99) / 1000.0
+        << " Max=" << h.max / 1000.0
+        << " (us)" << std::endl;
+    totals[s] = Histogram();
+  }
+}
+
+} // ycsbc
@@ -0,0 +1,115 @@
+//
+//  stage_breakdown.h
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#ifndef YCSB_C_STAGE_BREAKDOWN_H_
+#define YCSB_C_STAGE_BREAKDOWN_H_
+
+#include <cstdint>
+#include <ostream>
+
+#include "timer.h"
+
+namespace ycsbc {
+
+enum Stage {
+  STAGE_GENERATE = 0, // workload side: key choice, value generation, bookkeeping
+  STAGE_ENCODE,       // RowCodec::Encode
+  STAGE_ENGINE,       // binding call minus encode and decode
+  STAGE_DECODE,       // RowCodec::Decode and DecodeFilter
+  STAGE_VERIFY,       // dataintegrity checks
+  STAGE_RECORD,       // Measurements::Report
+  MAXSTAGE
+};
+
+extern const char *kStageString[];
+
+///
+/// Optional per-op latency breakdown (measurement.breakdown=true). Each
+/// client thread accumulates the stages of the op in flight, records them
+/// into thread-local histograms when the op ends, and merges those into the
+/// process totals at the end of the phase.
+///
+class StageBreakdown {
+ public:
+  static bool Enabled() { return enabled_; }
+  static void SetEnabled(bool enabled) { enabled_ = enabled; }
+
+  static uint64_t Now() {
+    return utils::TscClock::now().time_since_epoch().count();
+  }
+
+  ///
+  /// Adds ns to stage for the op in flight on this thread.
+  ///
+  static void Add(Stage stage, uint64_t ns);
+  ///
+  /// Time accumulated so far by the op in flight on this thread.
+  ///
+  static uint64_t Accumulated(Stage stage);
+
+  static void BeginOp();
+  ///
+  /// Ends the op in flight, charging whatever no other stage accounted for
+  /// to STAGE_GENERATE.
+  ///
+  static void EndOp();
+
+  ///
+  /// Merges this thread's histograms into the process totals. Called by
+  /// each client thread when it finishes a phase.
+  ///
+  static void FlushThread();
+
+  ///
+  /// Prints one line per stage for the phase and resets the totals.
+  ///
+  static void Report(std::ostream &out, const char *phase);
+
+ private:
+  static bool enabled_;
+};
+
+///
+/// Adds the time from construction to destruction to a stage, when the
+/// breakdown is enabled.
+///
+class ScopedStage {
+ public:
+  explicit ScopedStage(Stage stage)
+      : stage_(stage), start_(StageBreakdown::Enabled() ? StageBreakdown::Now() : 0) {}
+  ~ScopedStage() {
+    if (start_ != 0) {
+      StageBreakdown::Add(stage_, StageBreakdown::Now() - start_);
+    }
+  }
+ private:
+  Stage stage_;
+  uint64_t start_;
+};
+
+///
+/// Brackets one workload op with BeginOp/EndOp, when the breakdown is enabled.
+///
+class StageOp {
+ public:
+  StageOp() : active_(StageBreakdown::Enabled()) {
+    if (active_) {
+      StageBreakdown::BeginOp();
+    }
+  }
+  ~StageOp() {
+    if (active_) {
+      StageBreakdown::EndOp();
+    }
+  }
+ private:
+  bool active_;
+};
+
+} // ycsbc
+
+#endif // YCSB_C_STAGE_BREAKDOWN_H_
@@ -0,0 +1,77 @@
+//
+//  timer.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#include "timer.h"
+
+#ifdef YCSB_C_HAVE_TSC
+#include <cpuid.h>
+#endif
+
+namespace {
+
+#ifdef YCSB_C_HAVE_TSC
+uint64_t MonotonicRawNanos() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// CPUID.80000007H:EDX[8], the TSC ticks at a constant rate across P-, C- and T-states
+bool HasInvariantTsc() {
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+    return false;
+  }
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx & (1u << 8)) != 0;
+}
+#endif
+
+struct Calibration {
+  Calibration() {
+    ycsbc::utils::TscClock::Calibrate();
+  }
+} calibration;
+
+} // anonymous
+
+namespace ycsbc {
+
+namespace utils {
+
+uint64_t TscClock::tsc_base_ = 0;
+uint64_t TscClock::tsc_mult_ = 0;
+
+void TscClock::Calibrate(bool force_fallback) {
+  tsc_mult_ = 0;
+#ifdef YCSB_C_HAVE_TSC
+  if (force_fallback || !HasInvariantTsc()) {
+    return;
+  }
+  // 20ms against the raw monotonic clock puts the rate error well below 0.1%
+  const uint64_t ns_begin = MonotonicRawNanos();
+  const uint64_t tsc_begin = __rdtsc();
+  uint64_t ns_end;
+  do {
+    ns_end = MonotonicRawNanos();
+  } while (ns_end - ns_begin < 20 * 1000 * 1000);
+  const uint64_t tsc_end = __rdtsc();
+  if (tsc_end <= tsc_begin) {
+    return;
+  }
+  const unsigned __int128 mult =
+      (static_cast<unsigned __int128>(ns_end - ns_begin) << kShift) / (tsc_end - tsc_begin);
+  tsc_base_ = tsc_begin;
+  tsc_mult_ = static_cast<uint64_t>(mult);
+#else
+  (void)force_fallback;
+#endif
+}
+
+} // utils
+
+} // ycsbc
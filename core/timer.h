@@ -10,11 +10,60 @@
 #define YCSB_C_TIMER_H_
 
 #include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define YCSB_C_HAVE_TSC 1
+#endif
 
 namespace ycsbc {
 
 namespace utils {
 
+///
+/// Steady clock read from the invariant TSC when the CPU has one, scaled to
+/// nanoseconds with a factor calibrated against CLOCK_MONOTONIC_RAW at
+/// startup. Falls back to CLOCK_MONOTONIC_RAW on other CPUs.
+///
+class TscClock {
+ public:
+  using rep = int64_t;
+  using period = std::nano;
+  using duration = std::chrono::nanoseconds;
+  using time_point = std::chrono::time_point<TscClock>;
+  static constexpr bool is_steady = true;
+
+  static time_point now() noexcept {
+#ifdef YCSB_C_HAVE_TSC
+    if (tsc_mult_ != 0) {
+      unsigned __int128 ns = static_cast<unsigned __int128>(__rdtsc() - tsc_base_) * tsc_mult_;
+      return time_point(duration(static_cast<rep>(ns >> kShift)));
+    }
+#endif
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return time_point(duration(static_cast<rep>(ts.tv_sec) * 1000000000 + ts.tv_nsec));
+  }
+
+  ///
+  /// Whether now() reads the TSC, false if the calibration rejected it.
+  ///
+  static bool UsesTsc() { return tsc_mult_ != 0; }
+
+  ///
+  /// Calibrates the TSC, done once before main; with force_fallback the
+  /// clock switches to CLOCK_MONOTONIC_RAW.
+  ///
+  static void Calibrate(bool force_fallback = false);
+
+ private:
+  static constexpr int kShift = 32;
+  static uint64_t tsc_base_;
+  static uint64_t tsc_mult_; // ns per tick << kShift, 0 when not using the TSC
+};
+
 template <typename R, typename P = std::ratio<1>>
 class Timer {
  public:
@@ -22,6 +71,14 @@ class Timer {
     time_ = Clock::now();
   }
 
+  ///
+  /// Restarts the timer as if it had already been running for elapsed,
+  /// so time spent between End() and Start(elapsed) is not counted.
+  ///
+  void Start(R elapsed) {
+    time_ = Clock::now() - std::chrono::duration_cast<Clock::duration>(Duration(elapsed));
+  }
+
   R End() {
     Duration span;
     Clock::time_point t = Clock::now();
@@ -31,7 +88,7 @@ class Timer {
 
  private:
   using Duration = std::chrono::duration<R, P>;
-  using Clock = std::chrono::high_resolution_clock;
+  using Clock = TscClock;
 
   Clock::time_point time_;
 };
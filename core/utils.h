@@ -11,10 +11,13 @@
 #define YCSB_C_UTILS_H_
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <exception>
 #include <random>
 #include <locale>
+#include <string>
+#include <vector>
 
 #if defined(_MSC_VER)
 #if _MSC_VER >= 1911
@@ -46,8 +49,26 @@ inline uint64_t FNVHash64(uint64_t val) {
   return hash;
 }
 
+inline uint64_t FNVHash64(const char *data, size_t len, uint64_t hash = kFNVOffsetBasis64) {
+  for (size_t i = 0; i < len; i++) {
+    hash = hash ^ static_cast<uint8_t>(data[i]);
+    hash = hash * kFNVPrime64;
+  }
+  return hash;
+}
+
 inline uint64_t Hash(uint64_t val) { return FNVHash64(val); }
 
+///
+/// SplitMix64 step; cheap deterministic stream for generating verifiable values.
+///
+inline uint64_t SplitMix64(uint64_t &state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
 inline uint32_t ThreadLocalRandomInt() {
   static thread_local std::random_device rd;
   static thread_local std::minstd_rand rn(rd());
@@ -95,6 +116,19 @@ inline std::string Trim(const std::string &str) {
       [](int c){ return std::isspace(c); }).base());
 }
 
+inline std::vector<std::string> Split(const std::string &str, char delim) {
+  std::vector<std::string> parts;
+  if (str.empty()) {
+    return parts;
+  }
+  size_t begin = 0;
+  for (size_t end; (end = str.find(delim, begin)) != std::string::npos; begin = end + 1) {
+    parts.push_back(str.substr(begin, end - begin));
+  }
+  parts.push_back(str.substr(begin));
+  return parts;
+}
+
 } // utils
 
 } // ycsbc
@@ -24,12 +24,14 @@
 #include "core_workload.h"
 #include "countdown_latch.h"
 #include "db_factory.h"
+#include "stage_breakdown.h"
 
 void UsageMessage(const char *command);
 bool StrStartWith(const char *str, const char *pre);
 void ParseCommandLine(int argc, const char *argv[], ycsbc::utils::Properties &props);
 
-void StatusThread(ycsbc::Measurements *measurements, CountDownLatch *latch, int interval) {
+void StatusThread(ycsbc::Measurements *measurements, ycsbc::DB *db, CountDownLatch *latch,
+                  int interval) {
   using namespace std::chrono;
   time_point<system_clock> start = system_clock::now();
   bool done = false;
@@ -41,7 +43,7 @@ void StatusThread(ycsbc::Measurements *measurements, CountDownLatch *latch, int
     std::cout << std::put_time(std::localtime(&now_c), "%F %T") << ' '
               << static_cast<long long>(elapsed_time.count()) << " sec: ";
 
-    std::cout << measurements->GetStatusMsg() << std::endl;
+    std::cout << measurements->GetStatusMsg() << db->StatusMsg() << std::endl;
 
     if (done) {
       break;
@@ -79,8 +81,10 @@ int main(const int argc, const char *argv[]) {
     }
     dbs.push_back(db);
   }
+  const ycsbc::DBFactory::ClientRunner client = ycsbc::DBFactory::GetClient(&props);
 
   ycsbc::CoreWorkload wl;
+  wl.SetMeasurements(measurements);
   wl.Init(props);
 
   const bool show_status = (props.GetProperty("status", "false") == "true");
@@ -93,27 +97,46 @@ int main(const int argc, const char *argv[]) {
     CountDownLatch latch(num_threads);
     ycsbc::utils::Timer<double> timer;
 
+    dbs[0]->PhaseBegin("Load");
     timer.Start();
     std::future<void> status_future;
     if (show_status) {
       status_future = std::async(std::launch::async, StatusThread,
-                                 measurements, &latch, status_interval);
+                                 measurements, dbs[0], &latch, status_interval);
     }
-    std::vector<std::future<int>> client_threads;
-    for (int i = 0; i < num_threads; ++i) {
-      int thread_ops = total_ops / num_threads;
-      if (i < total_ops % num_threads) {
-        thread_ops++;
+    int sum = 0;
+    if (wl.bulk_load()) {
+      // the other instances open their handles once the tables are filled, so
+      // engines that need exclusive access to an empty table get it
+      dbs[0]->Init();
+      sum = wl.BulkLoad(*dbs[0], total_ops, num_threads);
+      for (int i = 1; i < num_threads; ++i) {
+        dbs[i]->Init();
       }
-      client_threads.emplace_back(std::async(std::launch::async, ycsbc::ClientThread, dbs[i], &wl,
-                                             thread_ops, true, true, !do_transaction, &latch));
-    }
-    assert((int)client_threads.size() == num_threads);
+      if (!do_transaction) {
+        for (ycsbc::DB *db : dbs) {
+          db->Cleanup();
+        }
+      }
+      for (int i = 0; i < num_threads; ++i) {
+        latch.CountDown();
+      }
+    } else {
+      std::vector<std::future<int>> client_threads;
+      for (int i = 0; i < num_threads; ++i) {
+        int thread_ops = total_ops / num_threads;
+        if (i < total_ops % num_threads) {
+          thread_ops++;
+        }
+        client_threads.emplace_back(std::async(std::launch::async, client, dbs[i], &wl,
+                                               thread_ops, true, true, !do_transaction, &latch));
+      }
+      assert((int)client_threads.size() == num_threads);
 
-    int sum = 0;
-    for (auto &n : client_threads) {
-      assert(n.valid());
-      sum += n.get();
+      for (auto &n : client_threads) {
+        assert(n.valid());
+        sum += n.get();
+      }
     }
     double runtime = timer.End();
 
@@ -124,6 +147,8 @@ int main(const int argc, const char *argv[]) {
     std::cout << "Load runtime(sec): " << runtime << std::endl;
     std::cout << "Load operations(ops): " << sum << std::endl;
     std::cout << "Load throughput(ops/sec): " << sum / runtime << std::endl;
+    ycsbc::StageBreakdown::Report(std::cout, "Load");
+    dbs[0]->PhaseReport(std::cout, "Load");
   }
 
   measurements->Reset();
@@ -136,11 +161,12 @@ int main(const int argc, const char *argv[]) {
     CountDownLatch latch(num_threads);
     ycsbc::utils::Timer<double> timer;
 
+    dbs[0]->PhaseBegin("Run");
     timer.Start();
     std::future<void> status_future;
     if (show_status) {
       status_future = std::async(std::launch::async, StatusThread,
-                                 measurements, &latch, status_interval);
+                                 measurements, dbs[0], &latch, status_interval);
     }
     std::vector<std::future<int>> client_threads;
     for (int i = 0; i < num_threads; ++i) {
@@ -148,7 +174,7 @@ int main(const int argc, const char *argv[]) {
       if (i < total_ops % num_threads) {
         thread_ops++;
       }
-      client_threads.emplace_back(std::async(std::launch::async, ycsbc::ClientThread, dbs[i], &wl,
+      client_threads.emplace_back(std::async(std::launch::async, client, dbs[i], &wl,
                                              thread_ops, false, !do_load, true,  &latch));
     }
     assert((int)client_threads.size() == num_threads);
@@ -167,6 +193,8 @@ int main(const int argc, const char *argv[]) {
     std::cout << "Run runtime(sec): " << runtime << std::endl;
     std::cout << "Run operations(ops): " << sum << std::endl;
     std::cout << "Run throughput(ops/sec): " << sum / runtime << std::endl;
+    ycsbc::StageBreakdown::Report(std::cout, "Run");
+    dbs[0]->PhaseReport(std::cout, "Run");
   }
 
   for (int i = 0; i < num_threads; i++) {
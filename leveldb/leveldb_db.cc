@@ -10,8 +10,11 @@
 #include "core/properties.h"
 #include "core/utils.h"
 #include "core/core_workload.h"
+#include "core/client.h"
 #include "core/db_factory.h"
 
+#include <algorithm>
+
 #include <leveldb/options.h>
 #include <leveldb/write_batch.h>
 
@@ -65,6 +68,8 @@ void LeveldbDB::Init() {
     format_ = kSingleEntry;
     method_read_ = &LeveldbDB::ReadSingleEntry;
     method_scan_ = &LeveldbDB::ScanSingleEntry;
+    method_reverse_scan_ = &LeveldbDB::ReverseScanSingleEntry;
+    method_range_scan_ = &LeveldbDB::RangeScanSingleEntry;
     method_update_ = &LeveldbDB::UpdateSingleEntry;
     method_insert_ = &LeveldbDB::InsertSingleEntry;
     method_delete_ = &LeveldbDB::DeleteSingleEntry;
@@ -72,6 +77,8 @@ void LeveldbDB::Init() {
     format_ = kRowMajor;
     method_read_ = &LeveldbDB::ReadCompKeyRM;
     method_scan_ = &LeveldbDB::ScanCompKeyRM;
+    method_reverse_scan_ = &LeveldbDB::ReverseScanCompKeyRM;
+    method_range_scan_ = &LeveldbDB::RangeScanCompKeyRM;
     method_update_ = &LeveldbDB::InsertCompKey;
     method_insert_ = &LeveldbDB::InsertCompKey;
     method_delete_ = &LeveldbDB::DeleteCompKey;
@@ -79,6 +86,8 @@ void LeveldbDB::Init() {
     format_ = kColumnMajor;
     method_read_ = &LeveldbDB::ReadCompKeyCM;
     method_scan_ = &LeveldbDB::ScanCompKeyCM;
+    method_reverse_scan_ = &LeveldbDB::ReverseScanCompKeyCM;
+    method_range_scan_ = &LeveldbDB::RangeScanCompKeyCM;
     method_update_ = &LeveldbDB::InsertCompKey;
     method_insert_ = &LeveldbDB::InsertCompKey;
     method_delete_ = &LeveldbDB::DeleteCompKey;
@@ -87,8 +96,10 @@ void LeveldbDB::Init() {
   }
   fieldcount_ = std::stoi(props.GetProperty(CoreWorkload::FIELD_COUNT_PROPERTY,
                                             CoreWorkload::FIELD_COUNT_DEFAULT));
+  codec_ = RowCodec::FromProperties(props);
   field_prefix_ = props.GetProperty(CoreWorkload::FIELD_NAME_PREFIX,
                                     CoreWorkload::FIELD_NAME_PREFIX_DEFAULT);
+  table_prefix_ = CoreWorkload::TableNames(props).size() > 1;
 
   ref_cnt_++;
   if (db_) {
@@ -171,59 +182,6 @@ void LeveldbDB::GetOptions(const utils::Properties &props, leveldb::Options *opt
   }
 }
 
-void LeveldbDB::SerializeRow(const std::vector<Field> &values, std::string *data) {
-  for (const Field &field : values) {
-    uint32_t len = field.name.size();
-    data->append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-    data->append(field.name.data(), field.name.size());
-    len = field.value.size();
-    data->append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-    data->append(field.value.data(), field.value.size());
-  }
-}
-
-void LeveldbDB::DeserializeRowFilter(std::vector<Field> *values, const std::string &data,
-                                     const std::vector<std::string> &fields) {
-  const char *p = data.data();
-  const char *lim = p + data.size();
-
-  std::vector<std::string>::const_iterator filter_iter = fields.begin();
-  while (p != lim && filter_iter != fields.end()) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    if (*filter_iter == field) {
-      values->push_back({field, value});
-      filter_iter++;
-    }
-  }
-  assert(values->size() == fields.size());
-}
-
-void LeveldbDB::DeserializeRow(std::vector<Field> *values, const std::string &data) {
-  const char *p = data.data();
-  const char *lim = p + data.size();
-  while (p != lim) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    values->push_back({field, value});
-  }
-  assert(values->size() == fieldcount_);
-}
-
 std::string LeveldbDB::BuildCompKey(const std::string &key, const std::string &field_name) {
   switch (format_) {
     case kRowMajor:
@@ -238,13 +196,14 @@ std::string LeveldbDB::BuildCompKey(const std::string &key, const std::string &f
 }
 
 std::string LeveldbDB::KeyFromCompKey(const std::string &comp_key) {
-  size_t idx = comp_key.find(":");
+  // field names never contain ':', binary keys may
+  size_t idx = comp_key.rfind(':');
   assert(idx != std::string::npos);
   return comp_key.substr(0, idx);
 }
 
 std::string LeveldbDB::FieldFromCompKey(const std::string &comp_key) {
-  size_t idx = comp_key.find(":");
+  size_t idx = comp_key.rfind(':');
   assert(idx != std::string::npos);
   return comp_key.substr(idx + 1);
 }
@@ -260,9 +219,9 @@ DB::Status LeveldbDB::ReadSingleEntry(const std::string &table, const std::strin
     throw utils::Exception(std::string("LevelDB Get: ") + s.ToString());
   }
   if (fields != nullptr) {
-    DeserializeRowFilter(&result, data, *fields);
+    codec_.DecodeFilter(data, *fields, &result);
   } else {
-    DeserializeRow(&result, data);
+    codec_.Decode(data, &result);
   }
   return kOK;
 }
@@ -270,16 +229,17 @@ DB::Status LeveldbDB::ReadSingleEntry(const std::string &table, const std::strin
 DB::Status LeveldbDB::ScanSingleEntry(const std::string &table, const std::string &key, int len,
                                       const std::vector<std::string> *fields,
                                       std::vector<std::vector<Field>> &result) {
+  const std::string prefix = table_prefix_ ? TableKey(table, "") : "";
   leveldb::Iterator *db_iter = db_->NewIterator(leveldb::ReadOptions());
   db_iter->Seek(key);
-  for (int i = 0; db_iter->Valid() && i < len; i++) {
+  for (int i = 0; db_iter->Valid() && db_iter->key().starts_with(prefix) && i < len; i++) {
     std::string data = db_iter->value().ToString();
     result.push_back(std::vector<Field>());
     std::vector<Field> &values = result.back();
     if (fields != nullptr) {
-      DeserializeRowFilter(&values, data, *fields);
+      codec_.DecodeFilter(data, *fields, &values);
     } else {
-      DeserializeRow(&values, data);
+      codec_.Decode(data, &values);
     }
     db_iter->Next();
   }
@@ -287,6 +247,54 @@ DB::Status LeveldbDB::ScanSingleEntry(const std::string &table, const std::strin
   return kOK;
 }
 
+DB::Status LeveldbDB::ReverseScanSingleEntry(const std::string &table, const std::string &key,
+                                             int len, const std::vector<std::string> *fields,
+                                             std::vector<std::vector<Field>> &result) {
+  const std::string prefix = table_prefix_ ? TableKey(table, "") : "";
+  leveldb::Iterator *db_iter = db_->NewIterator(leveldb::ReadOptions());
+  // LevelDB has no SeekForPrev, step back from the first key past the start
+  db_iter->Seek(key);
+  if (!db_iter->Valid()) {
+    db_iter->SeekToLast();
+  } else if (db_iter->key() != key) {
+    db_iter->Prev();
+  }
+  for (int i = 0; db_iter->Valid() && db_iter->key().starts_with(prefix) && i < len; i++) {
+    std::string data = db_iter->value().ToString();
+    result.push_back(std::vector<Field>());
+    std::vector<Field> &values = result.back();
+    if (fields != nullptr) {
+      codec_.DecodeFilter(data, *fields, &values);
+    } else {
+      codec_.Decode(data, &values);
+    }
+    db_iter->Prev();
+  }
+  delete db_iter;
+  return kOK;
+}
+
+DB::Status LeveldbDB::RangeScanSingleEntry(const std::string &table, const std::string &start_key,
+                                           const std::string &end_key,
+                                           const std::vector<std::string> *fields,
+                                           std::vector<std::vector<Field>> &result) {
+  const leveldb::Slice end(end_key);
+  leveldb::Iterator *db_iter = db_->NewIterator(leveldb::ReadOptions());
+  for (db_iter->Seek(start_key); db_iter->Valid() && db_iter->key().compare(end) < 0;
+       db_iter->Next()) {
+    std::string data = db_iter->value().ToString();
+    result.push_back(std::vector<Field>());
+    std::vector<Field> &values = result.back();
+    if (fields != nullptr) {
+      codec_.DecodeFilter(data, *fields, &values);
+    } else {
+      codec_.Decode(data, &values);
+    }
+  }
+  delete db_iter;
+  return kOK;
+}
+
 DB::Status LeveldbDB::UpdateSingleEntry(const std::string &table, const std::string &key,
                                         std::vector<Field> &values) {
   std::string data;
@@ -297,7 +305,7 @@ DB::Status LeveldbDB::UpdateSingleEntry(const std::string &table, const std::str
     throw utils::Exception(std::string("LevelDB Get: ") + s.ToString());
   }
   std::vector<Field> current_values;
-  DeserializeRow(&current_values, data);
+  codec_.Decode(data, &current_values);
   for (Field &new_field : values) {
     bool found MAYBE_UNUSED = false;
     for (Field &cur_field : current_values) {
@@ -312,7 +320,7 @@ DB::Status LeveldbDB::UpdateSingleEntry(const std::string &table, const std::str
   leveldb::WriteOptions wopt;
 
   data.clear();
-  SerializeRow(current_values, &data);
+  codec_.Encode(current_values, &data);
   s = db_->Put(wopt, key, data);
   if (!s.ok()) {
     throw utils::Exception(std::string("LevelDB Put: ") + s.ToString());
@@ -323,7 +331,7 @@ DB::Status LeveldbDB::UpdateSingleEntry(const std::string &table, const std::str
 DB::Status LeveldbDB::InsertSingleEntry(const std::string &table, const std::string &key,
                                         std::vector<Field> &values) {
   std::string data;
-  SerializeRow(values, &data);
+  codec_.Encode(values, &data);
   leveldb::WriteOptions wopt;
   leveldb::Status s = db_->Put(wopt, key, data);
   if (!s.ok()) {
@@ -387,10 +395,11 @@ DB::Status LeveldbDB::ReadCompKeyRM(const std::string &table, const std::string
 DB::Status LeveldbDB::ScanCompKeyRM(const std::string &table, const std::string &key, int len,
                                     const std::vector<std::string> *fields,
                                     std::vector<std::vector<Field>> &result) {
+  const std::string prefix = table_prefix_ ? TableKey(table, "") : "";
   leveldb::Iterator *db_iter = db_->NewIterator(leveldb::ReadOptions());
   db_iter->Seek(key);
   assert(db_iter->Valid() && KeyFromCompKey(db_iter->key().ToString()) == key);
-  for (int i = 0; i < len && db_iter->Valid(); i++) {
+  for (int i = 0; i < len && db_iter->Valid() && db_iter->key().starts_with(prefix); i++) {
     result.push_back(std::vector<Field>());
     std::vector<Field> &values = result.back();
     if (fields != nullptr) {
@@ -427,6 +436,68 @@ DB::Status LeveldbDB::ScanCompKeyRM(const std::string &table, const std::string
   return kOK;
 }
 
+DB::Status LeveldbDB::ReverseScanCompKeyRM(const std::string &table, const std::string &key,
+                                           int len, const std::vector<std::string> *fields,
+                                           std::vector<std::vector<Field>> &result) {
+  const std::string prefix = table_prefix_ ? TableKey(table, "") : "";
+  leveldb::Iterator *db_iter = db_->NewIterator(leveldb::ReadOptions());
+  // ';' sorts right after ':', so this lands past the last field of key
+  db_iter->Seek(key + ";");
+  if (db_iter->Valid()) {
+    db_iter->Prev();
+  } else {
+    db_iter->SeekToLast();
+  }
+  // fields come in descending order, collect each row and flip it afterwards
+  std::string row_key;
+  while (db_iter->Valid() && db_iter->key().starts_with(prefix)) {
+    std::string comp_key = db_iter->key().ToString();
+    std::string cur_key = KeyFromCompKey(comp_key);
+    if (result.empty() || cur_key != row_key) {
+      if (result.size() == static_cast<size_t>(len)) {
+        break;
+      }
+      row_key = cur_key;
+      result.push_back(std::vector<Field>());
+    }
+    std::string cur_field = FieldFromCompKey(comp_key);
+    if (fields == nullptr || std::find(fields->begin(), fields->end(), cur_field) != fields->end()) {
+      result.back().push_back({cur_field, db_iter->value().ToString()});
+    }
+    db_iter->Prev();
+  }
+  for (std::vector<Field> &values : result) {
+    std::reverse(values.begin(), values.end());
+  }
+  delete db_iter;
+  return kOK;
+}
+
+DB::Status LeveldbDB::RangeScanCompKeyRM(const std::string &table, const std::string &start_key,
+                                         const std::string &end_key,
+                                         const std::vector<std::string> *fields,
+                                         std::vector<std::vector<Field>> &result) {
+  leveldb::Iterator *db_iter = db_->NewIterator(leveldb::ReadOptions());
+  std::string row_key;
+  for (db_iter->Seek(start_key); db_iter->Valid(); db_iter->Next()) {
+    std::string comp_key = db_iter->key().ToString();
+    std::string cur_key = KeyFromCompKey(comp_key);
+    if (cur_key >= end_key) {
+      break;
+    }
+    if (result.empty() || cur_key != row_key) {
+      row_key = cur_key;
+      result.push_back(std::vector<Field>());
+    }
+    std::string cur_field = FieldFromCompKey(comp_key);
+    if (fields == nullptr || std::find(fields->begin(), fields->end(), cur_field) != fields->end()) {
+      result.back().push_back({cur_field, db_iter->value().ToString()});
+    }
+  }
+  delete db_iter;
+  return kOK;
+}
+
 DB::Status LeveldbDB::ReadCompKeyCM(const std::string &table, const std::string &key,
                                     const std::vector<std::string> *fields,
                                     std::vector<Field> &result) {
@@ -439,6 +510,19 @@ DB::Status LeveldbDB::ScanCompKeyCM(const std::string &table, const std::string
   return kNotImplemented;
 }
 
+DB::Status LeveldbDB::ReverseScanCompKeyCM(const std::string &table, const std::string &key,
+                                           int len, const std::vector<std::string> *fields,
+                                           std::vector<std::vector<Field>> &result) {
+  return kNotImplemented;
+}
+
+DB::Status LeveldbDB::RangeScanCompKeyCM(const std::string &table, const std::string &start_key,
+                                         const std::string &end_key,
+                                         const std::vector<std::string> *fields,
+                                         std::vector<std::vector<Field>> &result) {
+  return kNotImplemented;
+}
+
 DB::Status LeveldbDB::InsertCompKey(const std::string &table, const std::string &key,
                                     std::vector<Field> &values) {
   leveldb::WriteOptions wopt;
@@ -480,4 +564,23 @@ DB *NewLeveldbDB() {
 
 const bool registered = DBFactory::RegisterDB("leveldb", NewLeveldbDB);
 
+static bool SingleEntryFormat(const utils::Properties &props) {
+  return props.GetProperty(PROP_FORMAT, PROP_FORMAT_DEFAULT) == "single";
+}
+
+static bool RowMajorFormat(const utils::Properties &props) {
+  return props.GetProperty(PROP_FORMAT, PROP_FORMAT_DEFAULT) == "row";
+}
+
+static bool ColumnMajorFormat(const utils::Properties &props) {
+  return props.GetProperty(PROP_FORMAT, PROP_FORMAT_DEFAULT) == "column";
+}
+
+const bool registered_single = RegisterStaticDB<LeveldbDB::Formatted<LeveldbDB::kSingleEntry>>(
+    "leveldb", SingleEntryFormat);
+const bool registered_row = RegisterStaticDB<LeveldbDB::Formatted<LeveldbDB::kRowMajor>>(
+    "leveldb", RowMajorFormat);
+const bool registered_column = RegisterStaticDB<LeveldbDB::Formatted<LeveldbDB::kColumnMajor>>(
+    "leveldb", ColumnMajorFormat);
+
 } // ycsbc
@@ -14,6 +14,7 @@
 
 #include "core/db.h"
 #include "core/properties.h"
+#include "core/row_codec.h"
 
 #include <leveldb/db.h>
 #include <leveldb/options.h>
@@ -32,41 +33,79 @@ class LeveldbDB : public DB {
 
   void Cleanup();
 
+  enum LdbFormat {
+    kSingleEntry,
+    kRowMajor,
+    kColumnMajor
+  };
+  template <LdbFormat F> class Formatted;
+
   Status Read(const std::string &table, const std::string &key,
               const std::vector<std::string> *fields, std::vector<Field> &result) {
+    if (table_prefix_) {
+      return (this->*(method_read_))(table, TableKey(table, key), fields, result);
+    }
     return (this->*(method_read_))(table, key, fields, result);
   }
 
   Status Scan(const std::string &table, const std::string &key, int len,
               const std::vector<std::string> *fields, std::vector<std::vector<Field>> &result) {
+    if (table_prefix_) {
+      return (this->*(method_scan_))(table, TableKey(table, key), len, fields, result);
+    }
     return (this->*(method_scan_))(table, key, len, fields, result);
   }
 
+  Status ReverseScan(const std::string &table, const std::string &key, int len,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    if (table_prefix_) {
+      return (this->*(method_reverse_scan_))(table, TableKey(table, key), len, fields, result);
+    }
+    return (this->*(method_reverse_scan_))(table, key, len, fields, result);
+  }
+
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    if (table_prefix_) {
+      return (this->*(method_range_scan_))(table, TableKey(table, start_key),
+                                           TableKey(table, end_key), fields, result);
+    }
+    return (this->*(method_range_scan_))(table, start_key, end_key, fields, result);
+  }
+
   Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    if (table_prefix_) {
+      return (this->*(method_update_))(table, TableKey(table, key), values);
+    }
     return (this->*(method_update_))(table, key, values);
   }
 
   Status Insert(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    if (table_prefix_) {
+      return (this->*(method_insert_))(table, TableKey(table, key), values);
+    }
     return (this->*(method_insert_))(table, key, values);
   }
 
   Status Delete(const std::string &table, const std::string &key) {
+    if (table_prefix_) {
+      return (this->*(method_delete_))(table, TableKey(table, key));
+    }
     return (this->*(method_delete_))(table, key);
   }
 
  private:
-  enum LdbFormat {
-    kSingleEntry,
-    kRowMajor,
-    kColumnMajor
-  };
   LdbFormat format_;
 
+  // LevelDB has no column families, so with multiple tables every key is
+  // prefixed by its table name and a NUL separator
+  static std::string TableKey(const std::string &table, const std::string &key) {
+    return table + '\0' + key;
+  }
+
   void GetOptions(const utils::Properties &props, leveldb::Options *opt);
-  void SerializeRow(const std::vector<Field> &values, std::string *data);
-  void DeserializeRowFilter(std::vector<Field> *values, const std::string &data,
-                            const std::vector<std::string> &fields);
-  void DeserializeRow(std::vector<Field> *values, const std::string &data);
   std::string BuildCompKey(const std::string &key, const std::string &field_name);
   std::string KeyFromCompKey(const std::string &comp_key);
   std::string FieldFromCompKey(const std::string &comp_key);
@@ -76,6 +115,12 @@ class LeveldbDB : public DB {
   Status ScanSingleEntry(const std::string &table, const std::string &key, int len,
                          const std::vector<std::string> *fields,
                          std::vector<std::vector<Field>> &result);
+  Status ReverseScanSingleEntry(const std::string &table, const std::string &key, int len,
+                                const std::vector<std::string> *fields,
+                                std::vector<std::vector<Field>> &result);
+  Status RangeScanSingleEntry(const std::string &table, const std::string &start_key,
+                              const std::string &end_key, const std::vector<std::string> *fields,
+                              std::vector<std::vector<Field>> &result);
   Status UpdateSingleEntry(const std::string &table, const std::string &key,
                            std::vector<Field> &values);
   Status InsertSingleEntry(const std::string &table, const std::string &key,
@@ -87,11 +132,23 @@ class LeveldbDB : public DB {
   Status ScanCompKeyRM(const std::string &table, const std::string &key, int len,
                        const std::vector<std::string> *fields,
                        std::vector<std::vector<Field>> &result);
+  Status ReverseScanCompKeyRM(const std::string &table, const std::string &key, int len,
+                              const std::vector<std::string> *fields,
+                              std::vector<std::vector<Field>> &result);
+  Status RangeScanCompKeyRM(const std::string &table, const std::string &start_key,
+                            const std::string &end_key, const std::vector<std::string> *fields,
+                            std::vector<std::vector<Field>> &result);
   Status ReadCompKeyCM(const std::string &table, const std::string &key,
                        const std::vector<std::string> *fields, std::vector<Field> &result);
   Status ScanCompKeyCM(const std::string &table, const std::string &key, int len,
                        const std::vector<std::string> *fields,
                        std::vector<std::vector<Field>> &result);
+  Status ReverseScanCompKeyCM(const std::string &table, const std::string &key, int len,
+                              const std::vector<std::string> *fields,
+                              std::vector<std::vector<Field>> &result);
+  Status RangeScanCompKeyCM(const std::string &table, const std::string &start_key,
+                            const std::string &end_key, const std::vector<std::string> *fields,
+                            std::vector<std::vector<Field>> &result);
   Status InsertCompKey(const std::string &table, const std::string &key,
                        std::vector<Field> &values);
   Status DeleteCompKey(const std::string &table, const std::string &key);
@@ -101,6 +158,12 @@ class LeveldbDB : public DB {
   Status (LeveldbDB::*method_scan_)(const std::string &, const std::string &, int,
                                     const std::vector<std::string> *,
                                     std::vector<std::vector<Field>> &);
+  Status (LeveldbDB::*method_reverse_scan_)(const std::string &, const std::string &, int,
+                                            const std::vector<std::string> *,
+                                            std::vector<std::vector<Field>> &);
+  Status (LeveldbDB::*method_range_scan_)(const std::string &, const std::string &,
+                                          const std::string &, const std::vector<std::string> *,
+                                          std::vector<std::vector<Field>> &);
   Status (LeveldbDB::*method_update_)(const std::string &, const std::string &,
                                       std::vector<Field> &);
   Status (LeveldbDB::*method_insert_)(const std::string &, const std::string &,
@@ -108,13 +171,95 @@ class LeveldbDB : public DB {
   Status (LeveldbDB::*method_delete_)(const std::string &, const std::string &);
 
   int fieldcount_;
+  RowCodec codec_;
   std::string field_prefix_;
+  bool table_prefix_;
 
   static leveldb::DB *db_;
   static int ref_cnt_;
   static std::mutex mu_;
 };
 
+///
+/// LeveldbDB compiled for one leveldb.format: each call goes straight to that
+/// format's method instead of through the method pointers chosen in Init.
+///
+template <LeveldbDB::LdbFormat F>
+class LeveldbDB::Formatted final : public LeveldbDB {
+ public:
+  Status Read(const std::string &table, const std::string &key,
+              const std::vector<std::string> *fields, std::vector<Field> &result) {
+    constexpr auto read = F == kSingleEntry ? &LeveldbDB::ReadSingleEntry
+                        : F == kRowMajor ? &LeveldbDB::ReadCompKeyRM : &LeveldbDB::ReadCompKeyCM;
+    if (table_prefix_) {
+      return (this->*read)(table, TableKey(table, key), fields, result);
+    }
+    return (this->*read)(table, key, fields, result);
+  }
+
+  Status Scan(const std::string &table, const std::string &key, int len,
+              const std::vector<std::string> *fields, std::vector<std::vector<Field>> &result) {
+    constexpr auto scan = F == kSingleEntry ? &LeveldbDB::ScanSingleEntry
+                        : F == kRowMajor ? &LeveldbDB::ScanCompKeyRM : &LeveldbDB::ScanCompKeyCM;
+    if (table_prefix_) {
+      return (this->*scan)(table, TableKey(table, key), len, fields, result);
+    }
+    return (this->*scan)(table, key, len, fields, result);
+  }
+
+  Status ReverseScan(const std::string &table, const std::string &key, int len,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    constexpr auto scan = F == kSingleEntry ? &LeveldbDB::ReverseScanSingleEntry
+                        : F == kRowMajor ? &LeveldbDB::ReverseScanCompKeyRM
+                        : &LeveldbDB::ReverseScanCompKeyCM;
+    if (table_prefix_) {
+      return (this->*scan)(table, TableKey(table, key), len, fields, result);
+    }
+    return (this->*scan)(table, key, len, fields, result);
+  }
+
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    constexpr auto scan = F == kSingleEntry ? &LeveldbDB::RangeScanSingleEntry
+                        : F == kRowMajor ? &LeveldbDB::RangeScanCompKeyRM
+                        : &LeveldbDB::RangeScanCompKeyCM;
+    if (table_prefix_) {
+      return (this->*scan)(table, TableKey(table, start_key), TableKey(table, end_key), fields,
+                           result);
+    }
+    return (this->*scan)(table, start_key, end_key, fields, result);
+  }
+
+  Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    constexpr auto update = F == kSingleEntry ? &LeveldbDB::UpdateSingleEntry
+                          : &LeveldbDB::InsertCompKey;
+    if (table_prefix_) {
+      return (this->*update)(table, TableKey(table, key), values);
+    }
+    return (this->*update)(table, key, values);
+  }
+
+  Status Insert(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    constexpr auto insert = F == kSingleEntry ? &LeveldbDB::InsertSingleEntry
+                          : &LeveldbDB::InsertCompKey;
+    if (table_prefix_) {
+      return (this->*insert)(table, TableKey(table, key), values);
+    }
+    return (this->*insert)(table, key, values);
+  }
+
+  Status Delete(const std::string &table, const std::string &key) {
+    constexpr auto del = F == kSingleEntry ? &LeveldbDB::DeleteSingleEntry
+                       : &LeveldbDB::DeleteCompKey;
+    if (table_prefix_) {
+      return (this->*del)(table, TableKey(table, key));
+    }
+    return (this->*del)(table, key);
+  }
+};
+
 DB *NewLeveldbDB();
 
 } // ycsbc
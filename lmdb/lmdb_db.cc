@@ -17,6 +17,7 @@
 #include "core/properties.h"
 #include "core/utils.h"
 #include "core/core_workload.h"
+#include "core/client.h"
 #include "core/db_factory.h"
 
 #include <lmdb.h>
@@ -42,12 +43,21 @@ namespace {
 
   const std::string PROP_WRITEMAP = "lmdb.writemap";
   const std::string PROP_WRITEMAP_DEFAULT = "false";
+
+  // records per write txn of a bulk load, bounding the dirty pages a txn holds
+  constexpr size_t kBulkLoadTxnRecords = 16384;
+
+  inline std::string_view ValueView(const MDB_val &val) {
+    return std::string_view(static_cast<const char *>(val.mv_data), val.mv_size);
+  }
 } // anonymous
 
 namespace ycsbc {
 
 MDB_env *LmdbDB::env_;
 MDB_dbi LmdbDB::dbi_;
+std::vector<std::string> LmdbDB::table_names_;
+std::vector<MDB_dbi> LmdbDB::table_dbi_;
 int LmdbDB::ref_cnt_ = 0;
 std::mutex LmdbDB::mutex_;
 
@@ -60,6 +70,8 @@ void LmdbDB::Init() {
     format_ = kSingleEntry;
     method_read_ = &LmdbDB::ReadSingleEntry;
     method_scan_ = &LmdbDB::ScanSingleEntry;
+    method_reverse_scan_ = &LmdbDB::ReverseScanSingleEntry;
+    method_range_scan_ = &LmdbDB::RangeScanSingleEntry;
     method_update_ = &LmdbDB::UpdateSingleEntry;
     method_insert_ = &LmdbDB::InsertSingleEntry;
     method_delete_ = &LmdbDB::DeleteSingleEntry;
@@ -68,6 +80,7 @@ void LmdbDB::Init() {
   }
   fieldcount_ = std::stoi(props.GetProperty(CoreWorkload::FIELD_COUNT_PROPERTY,
                                             CoreWorkload::FIELD_COUNT_DEFAULT));
+  codec_ = RowCodec::FromProperties(props);
   field_prefix_ = props.GetProperty(CoreWorkload::FIELD_NAME_PREFIX,
                                     CoreWorkload::FIELD_NAME_PREFIX_DEFAULT);
 
@@ -100,6 +113,14 @@ void LmdbDB::Init() {
       throw utils::Exception(std::string("Init mdb_env_set_mapsize: ") + mdb_strerror(ret));
     }
   }
+  // one named database per table; a single table keeps using the unnamed database
+  const std::vector<std::string> tables = CoreWorkload::TableNames(props);
+  if (tables.size() > 1) {
+    ret = mdb_env_set_maxdbs(env_, tables.size());
+    if (ret) {
+      throw utils::Exception(std::string("Init mdb_env_set_maxdbs: ") + mdb_strerror(ret));
+    }
+  }
   const std::string &db_path = props.GetProperty(PROP_DBPATH, PROP_DBPATH_DEFAULT);
   if (db_path == "") {
     throw utils::Exception("LMDB db path is missing");
@@ -122,6 +143,17 @@ void LmdbDB::Init() {
   if (ret) {
     throw utils::Exception(std::string("Init mdb_open: ") + mdb_strerror(ret));
   }
+  if (tables.size() > 1) {
+    for (const std::string &table : tables) {
+      MDB_dbi dbi;
+      ret = mdb_open(txn, table.c_str(), MDB_CREATE, &dbi);
+      if (ret) {
+        throw utils::Exception(std::string("Init mdb_open ") + table + ": " + mdb_strerror(ret));
+      }
+      table_dbi_.push_back(dbi);
+    }
+    table_names_ = tables;
+  }
   ret = mdb_txn_commit(txn);
   if (ret) {
     throw utils::Exception(std::string("Init mdb_txn_commit: ") + mdb_strerror(ret));
@@ -133,60 +165,139 @@ void LmdbDB::Cleanup() {
   if (--ref_cnt_) {
     return;
   }
+  for (MDB_dbi dbi : table_dbi_) {
+    mdb_close(env_, dbi);
+  }
+  table_dbi_.clear();
+  table_names_.clear();
   mdb_close(env_, dbi_);
   mdb_env_close(env_);
 }
 
-void LmdbDB::SerializeRow(const std::vector<Field> &values, std::string *data) {
-  for (const Field &field : values) {
-    uint32_t len = field.name.size();
-    data->append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-    data->append(field.name.data(), field.name.size());
-    len = field.value.size();
-    data->append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-    data->append(field.value.data(), field.value.size());
+// Named databases are found by table number, so no lookup key is built per op.
+MDB_dbi LmdbDB::GetDbi(std::string_view table) {
+  if (table_dbi_.empty()) {
+    return dbi_;
   }
+  int n = CoreWorkload::TableNumber(table_names_, table);
+  return n >= 0 ? table_dbi_[n] : dbi_;
 }
 
-void LmdbDB::DeserializeRowFilter(std::vector<Field> *values, const char *data_ptr, size_t data_len,
-                                  const std::vector<std::string> &fields) {
-  const char *p = data_ptr;
-  const char *lim = p + data_len;
-  std::vector<std::string>::const_iterator filter_iter = fields.begin();
-  while (p != lim && filter_iter != fields.end()) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    if (*filter_iter == field) {
-      values->push_back({field, value});
-      filter_iter++;
+// Pages of the map may be reused by writers once the read txn ends, so each value is
+// copied once into the arena instead of twice into std::strings.
+DB::Status LmdbDB::ReadView(std::string_view table, std::string_view key,
+                            const std::vector<std::string> *fields,
+                            std::vector<FieldView> &result) {
+  MDB_txn *txn;
+  MDB_val key_slice, val_slice;
+
+  key_slice.mv_data = static_cast<void *>(const_cast<char *>(key.data()));
+  key_slice.mv_size = key.size();
+
+  arena_.Reset();
+  result.clear();
+  int ret;
+  ret = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
+  if (ret) {
+    throw utils::Exception(std::string("Read mdb_txn_begin: ") + mdb_strerror(ret));
+  }
+  ret = mdb_get(txn, GetDbi(table), &key_slice, &val_slice);
+  if (ret == MDB_NOTFOUND) {
+    mdb_txn_abort(txn);
+    return kNotFound;
+  } else if (ret) {
+    throw utils::Exception(std::string("Read mdb_get: ") + mdb_strerror(ret));
+  }
+  std::string_view data = arena_.Copy(ValueView(val_slice));
+  mdb_txn_abort(txn);
+  if (fields != nullptr) {
+    codec_.DecodeFilter(data, *fields, &result);
+  } else {
+    codec_.Decode(data, &result);
+  }
+  return kOK;
+}
+
+DB::Status LmdbDB::ScanView(std::string_view table, std::string_view key, int len,
+                            const std::vector<std::string> *fields,
+                            std::vector<std::vector<FieldView>> &result) {
+  MDB_txn *txn;
+  MDB_cursor *cursor;
+  MDB_val key_slice, val_slice;
+
+  key_slice.mv_data = static_cast<void *>(const_cast<char *>(key.data()));
+  key_slice.mv_size = key.size();
+
+  arena_.Reset();
+  result.clear();
+  int ret;
+  ret = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
+  if (ret) {
+    throw utils::Exception(std::string("Scan mdb_txn_begin: ") + mdb_strerror(ret));
+  }
+  ret = mdb_cursor_open(txn, GetDbi(table), &cursor);
+  if (ret) {
+    throw utils::Exception(std::string("Scan mdb_cursor_open: ") + mdb_strerror(ret));
+  }
+  ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_SET_RANGE);
+  if (ret && ret != MDB_NOTFOUND) {
+    throw utils::Exception(std::string("Scan mdb_cursor_get: ") + mdb_strerror(ret));
+  }
+  for (int i = 0; !ret && i < len; i++) {
+    std::string_view data = arena_.Copy(ValueView(val_slice));
+    result.push_back(std::vector<FieldView>());
+    if (fields != nullptr) {
+      codec_.DecodeFilter(data, *fields, &result.back());
+    } else {
+      codec_.Decode(data, &result.back());
     }
+    ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_NEXT);
   }
-  assert(values->size() == fields.size());
+  mdb_cursor_close(cursor);
+  mdb_txn_abort(txn);
+  return kOK;
 }
 
-void LmdbDB::DeserializeRow(std::vector<Field> *values, const char *data_ptr, size_t data_len) {
-  const char *p = data_ptr;
-  const char *lim = p + data_len;
-  while (p != lim) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    values->push_back({field, value});
-  }
-  assert(values->size() == fieldcount_);
+DB::Status LmdbDB::ScanVisit(std::string_view table, std::string_view key, int len,
+                             const std::vector<std::string> *fields,
+                             const ScanVisitor &visitor) {
+  MDB_txn *txn;
+  MDB_cursor *cursor;
+  MDB_val key_slice, val_slice;
+
+  key_slice.mv_data = static_cast<void *>(const_cast<char *>(key.data()));
+  key_slice.mv_size = key.size();
+
+  // the views point into the memory map, valid until the read txn ends
+  std::vector<FieldView> record;
+  int ret;
+  ret = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
+  if (ret) {
+    throw utils::Exception(std::string("Scan mdb_txn_begin: ") + mdb_strerror(ret));
+  }
+  ret = mdb_cursor_open(txn, GetDbi(table), &cursor);
+  if (ret) {
+    throw utils::Exception(std::string("Scan mdb_cursor_open: ") + mdb_strerror(ret));
+  }
+  ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_SET_RANGE);
+  if (ret && ret != MDB_NOTFOUND) {
+    throw utils::Exception(std::string("Scan mdb_cursor_get: ") + mdb_strerror(ret));
+  }
+  for (int i = 0; !ret && i < len; i++) {
+    record.clear();
+    if (fields != nullptr) {
+      codec_.DecodeFilter(ValueView(val_slice), *fields, &record);
+    } else {
+      codec_.Decode(ValueView(val_slice), &record);
+    }
+    if (!visitor(record)) {
+      break;
+    }
+    ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_NEXT);
+  }
+  mdb_cursor_close(cursor);
+  mdb_txn_abort(txn);
+  return kOK;
 }
 
 DB::Status LmdbDB::ReadSingleEntry(const std::string &table, const std::string &key,
@@ -203,15 +314,14 @@ DB::Status LmdbDB::ReadSingleEntry(const std::string &table, const std::string &
   if (ret) {
     throw utils::Exception(std::string("Read mdb_txn_begin: ") + mdb_strerror(ret));
   }
-  ret = mdb_get(txn, dbi_, &key_slice, &val_slice);
+  ret = mdb_get(txn, GetDbi(table), &key_slice, &val_slice);
   if (ret) {
     throw utils::Exception(std::string("Read mdb_get: ") + mdb_strerror(ret));
   }
   if (fields != nullptr) {
-    DeserializeRowFilter(&result, static_cast<char *>(val_slice.mv_data), val_slice.mv_size,
-                         *fields);
+    codec_.DecodeFilter(ValueView(val_slice), *fields, &result);
   } else {
-    DeserializeRow(&result, static_cast<char *>(val_slice.mv_data), val_slice.mv_size);
+    codec_.Decode(ValueView(val_slice), &result);
   }
   mdb_txn_abort(txn);
   return kOK;
@@ -220,6 +330,15 @@ DB::Status LmdbDB::ReadSingleEntry(const std::string &table, const std::string &
 DB::Status LmdbDB::ScanSingleEntry(const std::string &table, const std::string &key, int len,
                                    const std::vector<std::string> *fields,
                                    std::vector<std::vector<Field>> &result) {
+  return ScanVisit(table, key, len, fields, [&result](const std::vector<FieldView> &record) {
+    AppendRecord(record, result);
+    return true;
+  });
+}
+
+DB::Status LmdbDB::ReverseScanSingleEntry(const std::string &table, const std::string &key,
+                                          int len, const std::vector<std::string> *fields,
+                                          std::vector<std::vector<Field>> &result) {
   MDB_txn *txn;
   MDB_cursor *cursor;
   MDB_val key_slice, val_slice;
@@ -228,27 +347,74 @@ DB::Status LmdbDB::ScanSingleEntry(const std::string &table, const std::string &
   key_slice.mv_size = key.size();
 
   int ret;
-  ret = mdb_txn_begin(env_, nullptr, 0, &txn);
+  ret = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
   if (ret) {
-    throw utils::Exception(std::string("Scan mdb_txn_begin: ") + mdb_strerror(ret));
+    throw utils::Exception(std::string("ReverseScan mdb_txn_begin: ") + mdb_strerror(ret));
   }
-  ret = mdb_cursor_open(txn, dbi_, &cursor);
+  ret = mdb_cursor_open(txn, GetDbi(table), &cursor);
   if (ret) {
-    throw utils::Exception(std::string("Scan mdb_cursor_open: ") + mdb_strerror(ret));
+    throw utils::Exception(std::string("ReverseScan mdb_cursor_open: ") + mdb_strerror(ret));
   }
-  ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_SET);
-  assert(ret != MDB_NOTFOUND);
-  if (ret) {
-    throw utils::Exception(std::string("Scan mdb_cursor_get: ") + mdb_strerror(ret));
+  // position on the last key <= key: the first key >= key, stepping back unless it is a match
+  ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_SET_RANGE);
+  if (ret == MDB_NOTFOUND) {
+    ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_LAST);
+  } else if (!ret && (key_slice.mv_size != key.size() ||
+                      memcmp(key_slice.mv_data, key.data(), key.size()) != 0)) {
+    ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_PREV);
+  }
+  if (ret && ret != MDB_NOTFOUND) {
+    throw utils::Exception(std::string("ReverseScan mdb_cursor_get: ") + mdb_strerror(ret));
   }
   for (int i = 0; !ret && i < len; i++) {
     result.push_back(std::vector<Field>());
     std::vector<Field> &values = result.back();
     if (fields != nullptr) {
-      DeserializeRowFilter(&values, static_cast<char *>(val_slice.mv_data), val_slice.mv_size,
-                           *fields);
+      codec_.DecodeFilter(ValueView(val_slice), *fields, &values);
     } else {
-      DeserializeRow(&values, static_cast<char *>(val_slice.mv_data), val_slice.mv_size);
+      codec_.Decode(ValueView(val_slice), &values);
+    }
+    ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_PREV);
+  }
+  mdb_cursor_close(cursor);
+  mdb_txn_abort(txn);
+  return kOK;
+}
+
+DB::Status LmdbDB::RangeScanSingleEntry(const std::string &table, const std::string &start_key,
+                                        const std::string &end_key,
+                                        const std::vector<std::string> *fields,
+                                        std::vector<std::vector<Field>> &result) {
+  MDB_txn *txn;
+  MDB_cursor *cursor;
+  MDB_val key_slice, val_slice, end_slice;
+  MDB_dbi dbi = GetDbi(table);
+
+  key_slice.mv_data = static_cast<void *>(const_cast<char *>(start_key.data()));
+  key_slice.mv_size = start_key.size();
+  end_slice.mv_data = static_cast<void *>(const_cast<char *>(end_key.data()));
+  end_slice.mv_size = end_key.size();
+
+  int ret;
+  ret = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn);
+  if (ret) {
+    throw utils::Exception(std::string("RangeScan mdb_txn_begin: ") + mdb_strerror(ret));
+  }
+  ret = mdb_cursor_open(txn, dbi, &cursor);
+  if (ret) {
+    throw utils::Exception(std::string("RangeScan mdb_cursor_open: ") + mdb_strerror(ret));
+  }
+  ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_SET_RANGE);
+  if (ret && ret != MDB_NOTFOUND) {
+    throw utils::Exception(std::string("RangeScan mdb_cursor_get: ") + mdb_strerror(ret));
+  }
+  while (!ret && mdb_cmp(txn, dbi, &key_slice, &end_slice) < 0) {
+    result.push_back(std::vector<Field>());
+    std::vector<Field> &values = result.back();
+    if (fields != nullptr) {
+      codec_.DecodeFilter(ValueView(val_slice), *fields, &values);
+    } else {
+      codec_.Decode(ValueView(val_slice), &values);
     }
     ret = mdb_cursor_get(cursor, &key_slice, &val_slice, MDB_NEXT);
   }
@@ -270,12 +436,12 @@ DB::Status LmdbDB::UpdateSingleEntry(const std::string &table, const std::string
   if (ret) {
     throw utils::Exception(std::string("Update mdb_txn_begin: ") + mdb_strerror(ret));
   }
-  ret = mdb_get(txn, dbi_, &key_slice, &val_slice);
+  ret = mdb_get(txn, GetDbi(table), &key_slice, &val_slice);
   if (ret) {
     throw utils::Exception(std::string("Update mdb_get: ") + mdb_strerror(ret));
   }
   std::vector<Field> current_values;
-  DeserializeRow(&current_values, static_cast<char *>(val_slice.mv_data), val_slice.mv_size);
+  codec_.Decode(ValueView(val_slice), &current_values);
   for (Field &new_field : values) {
     bool found MAYBE_UNUSED = false;
     for (Field &cur_field : current_values) {
@@ -289,10 +455,10 @@ DB::Status LmdbDB::UpdateSingleEntry(const std::string &table, const std::string
   }
 
   std::string data;
-  SerializeRow(current_values, &data);
+  codec_.Encode(current_values, &data);
   val_slice.mv_data = const_cast<char *>(data.data());
   val_slice.mv_size = data.size();
-  ret = mdb_put(txn, dbi_, &key_slice, &val_slice, 0);
+  ret = mdb_put(txn, GetDbi(table), &key_slice, &val_slice, 0);
   if (ret) {
     throw utils::Exception(std::string("Update mdb_put: ") + mdb_strerror(ret));
   }
@@ -313,7 +479,7 @@ DB::Status LmdbDB::InsertSingleEntry(const std::string &table, const std::string
   key_slice.mv_size = key.size();
 
   std::string data;
-  SerializeRow(values, &data);
+  codec_.Encode(values, &data);
   val_slice.mv_data = static_cast<void *>(const_cast<char *>(data.data()));
   val_slice.mv_size = data.size();
 
@@ -322,7 +488,7 @@ DB::Status LmdbDB::InsertSingleEntry(const std::string &table, const std::string
   if (ret) {
     throw utils::Exception(std::string("Insert mdb_txn_begin: ") + mdb_strerror(ret));
   }
-  ret = mdb_put(txn, dbi_, &key_slice, &val_slice, 0);
+  ret = mdb_put(txn, GetDbi(table), &key_slice, &val_slice, 0);
   if (ret) {
     throw utils::Exception(std::string("Insert mdb_put: ") + mdb_strerror(ret));
   }
@@ -333,6 +499,52 @@ DB::Status LmdbDB::InsertSingleEntry(const std::string &table, const std::string
   return kOK;
 }
 
+// MDB_APPEND fills pages from the right edge of the tree without searching it or
+// splitting pages in half, so the database ends up densely packed.
+DB::Status LmdbDB::BulkLoad(const std::string &table, RecordStream &records) {
+  MDB_txn *txn = nullptr;
+  MDB_val key_slice, val_slice;
+  const MDB_dbi dbi = GetDbi(table);
+
+  std::string key, data;
+  std::vector<Field> values;
+  size_t in_txn = 0;
+  int ret;
+  while (records.Next(&key, &values)) {
+    if (txn == nullptr) {
+      ret = mdb_txn_begin(env_, nullptr, 0, &txn);
+      if (ret) {
+        throw utils::Exception(std::string("BulkLoad mdb_txn_begin: ") + mdb_strerror(ret));
+      }
+    }
+    data.clear();
+    codec_.Encode(values, &data);
+    key_slice.mv_data = static_cast<void *>(const_cast<char *>(key.data()));
+    key_slice.mv_size = key.size();
+    val_slice.mv_data = static_cast<void *>(const_cast<char *>(data.data()));
+    val_slice.mv_size = data.size();
+    ret = mdb_put(txn, dbi, &key_slice, &val_slice, MDB_APPEND);
+    if (ret) {
+      throw utils::Exception(std::string("BulkLoad mdb_put: ") + mdb_strerror(ret));
+    }
+    if (++in_txn == kBulkLoadTxnRecords) {
+      ret = mdb_txn_commit(txn);
+      if (ret) {
+        throw utils::Exception(std::string("BulkLoad mdb_txn_commit: ") + mdb_strerror(ret));
+      }
+      txn = nullptr;
+      in_txn = 0;
+    }
+  }
+  if (txn != nullptr) {
+    ret = mdb_txn_commit(txn);
+    if (ret) {
+      throw utils::Exception(std::string("BulkLoad mdb_txn_commit: ") + mdb_strerror(ret));
+    }
+  }
+  return kOK;
+}
+
 DB::Status LmdbDB::DeleteSingleEntry(const std::string &table, const std::string &key) {
   MDB_txn *txn;
   MDB_val key_slice;
@@ -345,7 +557,7 @@ DB::Status LmdbDB::DeleteSingleEntry(const std::string &table, const std::string
   if (ret) {
     throw utils::Exception(std::string("Delete mdb_txn_begin: ") + mdb_strerror(ret));
   }
-  ret = mdb_del(txn, dbi_, &key_slice, nullptr);
+  ret = mdb_del(txn, GetDbi(table), &key_slice, nullptr);
   if (ret) {
     throw utils::Exception(std::string("Delete mdb_del: ") + mdb_strerror(ret));
   }
@@ -362,4 +574,10 @@ DB *NewLmdbDB() {
 
 const bool registered = DBFactory::RegisterDB("lmdb", NewLmdbDB);
 
+static bool SingleEntryFormat(const utils::Properties &props) {
+  return props.GetProperty(PROP_FORMAT, PROP_FORMAT_DEFAULT) == "single";
+}
+
+const bool registered_static = RegisterStaticDB<LmdbDB::SingleEntry>("lmdb", SingleEntryFormat);
+
 } // ycsbc
@@ -9,9 +9,12 @@
 #define YCSB_C_LMDB_DB_H_
 
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <vector>
 
 #include "core/db.h"
+#include "core/row_codec.h"
 
 #include <lmdb.h>
 
@@ -26,6 +29,8 @@ class LmdbDB : public DB {
 
   void Cleanup();
 
+  class SingleEntry;
+
   Status Read(const std::string &table, const std::string &key,
               const std::vector<std::string> *fields, std::vector<Field> &result) {
     return (this->*(method_read_))(table, key, fields, result);
@@ -36,6 +41,28 @@ class LmdbDB : public DB {
     return (this->*(method_scan_))(table, key, len, fields, result);
   }
 
+  Status ReadView(std::string_view table, std::string_view key,
+                  const std::vector<std::string> *fields, std::vector<FieldView> &result);
+
+  Status ScanView(std::string_view table, std::string_view key, int len,
+                  const std::vector<std::string> *fields,
+                  std::vector<std::vector<FieldView>> &result);
+
+  Status ScanVisit(std::string_view table, std::string_view key, int len,
+                   const std::vector<std::string> *fields, const ScanVisitor &visitor);
+
+  Status ReverseScan(const std::string &table, const std::string &key, int len,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    return (this->*(method_reverse_scan_))(table, key, len, fields, result);
+  }
+
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    return (this->*(method_range_scan_))(table, start_key, end_key, fields, result);
+  }
+
   Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
     return (this->*(method_update_))(table, key, values);
   }
@@ -48,6 +75,8 @@ class LmdbDB : public DB {
     return (this->*(method_delete_))(table, key);
   }
 
+  Status BulkLoad(const std::string &table, RecordStream &records);
+
  private:
   enum LmdbFormat {
     kSingleEntry,
@@ -56,16 +85,19 @@ class LmdbDB : public DB {
   };
   LmdbFormat format_;
 
-  void SerializeRow(const std::vector<Field> &values, std::string *data);
-  void DeserializeRowFilter(std::vector<Field> *values, const char *data_ptr, size_t data_len,
-                            const std::vector<std::string> &fields);
-  void DeserializeRow(std::vector<Field> *values, const char *data_ptr, size_t data_len);
+  MDB_dbi GetDbi(std::string_view table);
 
   Status ReadSingleEntry(const std::string &table, const std::string &key,
                          const std::vector<std::string> *fields, std::vector<Field> &result);
   Status ScanSingleEntry(const std::string &table, const std::string &key, int len,
                          const std::vector<std::string> *fields,
                          std::vector<std::vector<Field>> &result);
+  Status ReverseScanSingleEntry(const std::string &table, const std::string &key, int len,
+                                const std::vector<std::string> *fields,
+                                std::vector<std::vector<Field>> &result);
+  Status RangeScanSingleEntry(const std::string &table, const std::string &start_key,
+                              const std::string &end_key, const std::vector<std::string> *fields,
+                              std::vector<std::vector<Field>> &result);
   Status UpdateSingleEntry(const std::string &table, const std::string &key,
                            std::vector<Field> &values);
   Status InsertSingleEntry(const std::string &table, const std::string &key,
@@ -77,19 +109,69 @@ class LmdbDB : public DB {
   Status (LmdbDB::*method_scan_)(const std::string &, const std::string &, int,
                                  const std::vector<std::string> *,
                                  std::vector<std::vector<Field>> &);
+  Status (LmdbDB::*method_reverse_scan_)(const std::string &, const std::string &, int,
+                                         const std::vector<std::string> *,
+                                         std::vector<std::vector<Field>> &);
+  Status (LmdbDB::*method_range_scan_)(const std::string &, const std::string &,
+                                       const std::string &, const std::vector<std::string> *,
+                                       std::vector<std::vector<Field>> &);
   Status (LmdbDB::*method_update_)(const std::string &, const std::string &, std::vector<Field> &);
   Status (LmdbDB::*method_insert_)(const std::string &, const std::string &, std::vector<Field> &);
   Status (LmdbDB::*method_delete_)(const std::string &, const std::string &);
 
   unsigned fieldcount_;
+  RowCodec codec_;
   std::string field_prefix_;
 
   static MDB_env *env_;
   static MDB_dbi dbi_;
+  static std::vector<std::string> table_names_;
+  static std::vector<MDB_dbi> table_dbi_; // by table number, empty with a single table
   static int ref_cnt_;
   static std::mutex mutex_;
 };
 
+///
+/// LmdbDB compiled for lmdb.format=single: each call goes straight to the
+/// *SingleEntry method instead of through the method pointers chosen in Init.
+///
+class LmdbDB::SingleEntry final : public LmdbDB {
+ public:
+  Status Read(const std::string &table, const std::string &key,
+              const std::vector<std::string> *fields, std::vector<Field> &result) {
+    return ReadSingleEntry(table, key, fields, result);
+  }
+
+  Status Scan(const std::string &table, const std::string &key, int len,
+              const std::vector<std::string> *fields, std::vector<std::vector<Field>> &result) {
+    return ScanSingleEntry(table, key, len, fields, result);
+  }
+
+  Status ReverseScan(const std::string &table, const std::string &key, int len,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    return ReverseScanSingleEntry(table, key, len, fields, result);
+  }
+
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    return RangeScanSingleEntry(table, start_key, end_key, fields, result);
+  }
+
+  Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    return UpdateSingleEntry(table, key, values);
+  }
+
+  Status Insert(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    return InsertSingleEntry(table, key, values);
+  }
+
+  Status Delete(const std::string &table, const std::string &key) {
+    return DeleteSingleEntry(table, key);
+  }
+};
+
 DB *NewLmdbDB();
 
 } // ycsbc
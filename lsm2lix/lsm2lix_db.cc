@@ -28,6 +28,11 @@ void LSM2LIXDB::Init() {
   method_delete_ = &LSM2LIXDB::DeleteSingle;
 
   fieldcount_ = std::stoi(props.GetProperty(CoreWorkload::FIELD_COUNT_PROPERTY, CoreWorkload::FIELD_COUNT_DEFAULT));
+  codec_ = RowCodec::FromProperties(props);
+  // a single integer-keyed index, there is no namespace to map extra tables to
+  if (CoreWorkload::TableNames(props).size() > 1) {
+    throw utils::Exception("LSM2LIX supports a single table only");
+  }
   ref_cnt_++;
   if (db_) {
     return;
@@ -48,66 +53,6 @@ void LSM2LIXDB::Cleanup() {
   delete db_;
 }
 
-void LSM2LIXDB::SerializeRow(const std::vector<Field> &values, std::string &data) {
-  for (const Field &field : values) {
-    uint32_t len = field.name.size();
-    data.append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-    data.append(field.name.data(), field.name.size());
-    len = field.value.size();
-    data.append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-    data.append(field.value.data(), field.value.size());
-  }
-}
-
-void LSM2LIXDB::DeserializeRowFilter(std::vector<Field> &values, const char *p, const char *lim,
-                                     const std::vector<std::string> &fields) {
-  std::vector<std::string>::const_iterator filter_iter = fields.begin();
-  while (p != lim && filter_iter != fields.end()) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    if (*filter_iter == field) {
-      values.push_back({field, value});
-      filter_iter++;
-    }
-  }
-  assert(values.size() == fields.size());
-}
-
-void LSM2LIXDB::DeserializeRowFilter(std::vector<Field> &values, const std::string &data,
-                                     const std::vector<std::string> &fields) {
-  const char *p = data.data();
-  const char *lim = p + data.size();
-  DeserializeRowFilter(values, p, lim, fields);
-}
-
-void LSM2LIXDB::DeserializeRow(std::vector<Field> &values, const char *p, const char *lim) {
-  while (p != lim) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    values.push_back({field, value});
-  }
-}
-
-void LSM2LIXDB::DeserializeRow(std::vector<Field> &values, const std::string &data) {
-  const char *p = data.data();
-  const char *lim = p + data.size();
-  DeserializeRow(values, p, lim);
-}
-
 DB::Status LSM2LIXDB::ReadSingle(const std::string &table, const std::string &key,
                                  const std::vector<std::string> *fields,
                                  std::vector<Field> &result) {
@@ -119,9 +64,9 @@ DB::Status LSM2LIXDB::ReadSingle(const std::string &table, const std::string &ke
     throw utils::Exception(std::string("LSMLIXDB Get: ") + s.ToString());
   }
   if (fields != nullptr) {
-    DeserializeRowFilter(result, data, *fields);
+    codec_.DecodeFilter(data, *fields, &result);
   } else {
-    DeserializeRow(result, data);
+    codec_.Decode(data, &result);
     assert(result.size() == static_cast<size_t>(fieldcount_));
   }
   return kOK;
@@ -140,7 +85,7 @@ DB::Status LSM2LIXDB::UpdateSingle(const std::string &table, const std::string &
 DB::Status LSM2LIXDB::InsertSingle(const std::string &table, const std::string &key,
                                    std::vector<Field> &values) {
   std::string data;
-  SerializeRow(values, data);
+  codec_.Encode(values, &data);
   LSM2LIX::Status s = db_->Put(key, data);
   if (!s.ok()) {
     throw utils::Exception(std::string("LSM2LIX Put: ") + s.ToString());
@@ -11,6 +11,7 @@
 
 #include "core/db.h"
 #include "core/properties.h"
+#include "core/row_codec.h"
 
 #include <LSM2LIX.h>
 
@@ -51,14 +52,6 @@ class LSM2LIXDB : public DB {
 
   //void GetOptions(const utils::Properties &props, tl::pg::PageGroupedDBOptions *opts);
 
-  static void SerializeRow(const std::vector<Field> &values, std::string &data);
-  static void DeserializeRowFilter(std::vector<Field> &values, const char *p, const char *lim,
-                                   const std::vector<std::string> &fields);
-  static void DeserializeRowFilter(std::vector<Field> &values, const std::string &data,
-                                   const std::vector<std::string> &fields);
-  static void DeserializeRow(std::vector<Field> &values, const char *p, const char *lim);
-  static void DeserializeRow(std::vector<Field> &values, const std::string &data);
-
   Status ReadSingle(const std::string &table, const std::string &key,
                     const std::vector<std::string> *fields, std::vector<Field> &result);
   Status ScanSingle(const std::string &table, const std::string &key, int len,
@@ -82,6 +75,7 @@ class LSM2LIXDB : public DB {
   Status (LSM2LIXDB::*method_delete_)(const std::string &, const std::string &);
 
   int fieldcount_;
+  RowCodec codec_;
 
   static LSM2LIX::LSM2LIX *db_;
   static int ref_cnt_;
@@ -7,17 +7,36 @@
 //
 
 #include "rocksdb_db.h"
+#include "rocksdb_merge.h"
 
 #include "core/core_workload.h"
+#include "core/client.h"
 #include "core/db_factory.h"
 #include "core/properties.h"
+#include "core/timer.h"
 #include "core/utils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
 #include <rocksdb/cache.h>
 #include <rocksdb/filter_policy.h>
+#include <rocksdb/iostats_context.h>
 #include <rocksdb/merge_operator.h>
+#include <rocksdb/perf_context.h>
+#include <rocksdb/perf_level.h>
+#include <rocksdb/rate_limiter.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/statistics.h>
+#include <rocksdb/sst_file_writer.h>
 #include <rocksdb/status.h>
+#include <rocksdb/table.h>
 #include <rocksdb/utilities/options_util.h>
+#include <rocksdb/wide_columns.h>
 #include <rocksdb/write_batch.h>
 
 
@@ -31,12 +50,77 @@ namespace {
   const std::string PROP_MERGEUPDATE = "rocksdb.mergeupdate";
   const std::string PROP_MERGEUPDATE_DEFAULT = "false";
 
+  const std::string PROP_MAX_SUCCESSIVE_MERGES = "rocksdb.max_successive_merges";
+  const std::string PROP_MAX_SUCCESSIVE_MERGES_DEFAULT = "0";
+
+  const std::string PROP_ASYNC_IO = "rocksdb.async_io";
+  const std::string PROP_ASYNC_IO_DEFAULT = "true";
+
+  const std::string PROP_CACHE_ITERATORS = "rocksdb.cache_iterators";
+  const std::string PROP_CACHE_ITERATORS_DEFAULT = "true";
+
+  const std::string PROP_SCAN_READAHEAD = "rocksdb.scan.readahead_size";
+  const std::string PROP_SCAN_READAHEAD_DEFAULT = "0";
+
+  const std::string PROP_SCAN_PIN_DATA = "rocksdb.scan.pin_data";
+  const std::string PROP_SCAN_PIN_DATA_DEFAULT = "false";
+
+  const std::string PROP_SCAN_AUTO_PREFIX = "rocksdb.scan.auto_prefix_mode";
+  const std::string PROP_SCAN_AUTO_PREFIX_DEFAULT = "false";
+
+  const std::string PROP_SCAN_UPPER_BOUND = "rocksdb.scan.iterate_upper_bound";
+  const std::string PROP_SCAN_UPPER_BOUND_DEFAULT = "";
+
+  // rocksdb.load.write.<option> and rocksdb.run.write.<option> override these for one phase
+  const std::string PROP_WRITE_DISABLE_WAL = "write.disable_wal";
+  const std::string PROP_WRITE_DISABLE_WAL_DEFAULT = "false";
+
+  const std::string PROP_WRITE_SYNC = "write.sync";
+  const std::string PROP_WRITE_SYNC_DEFAULT = "false";
+
+  const std::string PROP_WRITE_NO_SLOWDOWN = "write.no_slowdown";
+  const std::string PROP_WRITE_NO_SLOWDOWN_DEFAULT = "false";
+
+  const std::string PROP_WRITE_LOW_PRI = "write.low_pri";
+  const std::string PROP_WRITE_LOW_PRI_DEFAULT = "false";
+
+  // empty keeps the RocksDB default, or the value from the options file
+  const std::string PROP_PIPELINED_WRITE = "rocksdb.enable_pipelined_write";
+  const std::string PROP_PIPELINED_WRITE_DEFAULT = "";
+
+  const std::string PROP_UNORDERED_WRITE = "rocksdb.unordered_write";
+  const std::string PROP_UNORDERED_WRITE_DEFAULT = "";
+
+  const std::string PROP_CONCURRENT_MEMTABLE_WRITE = "rocksdb.allow_concurrent_memtable_write";
+  const std::string PROP_CONCURRENT_MEMTABLE_WRITE_DEFAULT = "";
+
+  const std::string PROP_TWO_WRITE_QUEUES = "rocksdb.two_write_queues";
+  const std::string PROP_TWO_WRITE_QUEUES_DEFAULT = "";
+
+  const std::string PROP_PERF_LEVEL = "rocksdb.perf_level";
+  const std::string PROP_PERF_LEVEL_DEFAULT = "disable";
+
   const std::string PROP_DESTROY = "rocksdb.destroy";
   const std::string PROP_DESTROY_DEFAULT = "false";
 
   const std::string PROP_COMPRESSION = "rocksdb.compression";
   const std::string PROP_COMPRESSION_DEFAULT = "no";
 
+  const std::string PROP_COMPRESSION_PER_LEVEL = "rocksdb.compression_per_level";
+  const std::string PROP_COMPRESSION_PER_LEVEL_DEFAULT = "";
+
+  const std::string PROP_BOTTOMMOST_COMPRESSION = "rocksdb.bottommost_compression";
+  const std::string PROP_BOTTOMMOST_COMPRESSION_DEFAULT = "";
+
+  const std::string PROP_COMPRESSION_LEVEL = "rocksdb.compression_level";
+  const std::string PROP_COMPRESSION_LEVEL_DEFAULT = "";
+
+  const std::string PROP_COMPRESSION_MAX_DICT_BYTES = "rocksdb.compression_max_dict_bytes";
+  const std::string PROP_COMPRESSION_MAX_DICT_BYTES_DEFAULT = "0";
+
+  const std::string PROP_COMPRESSION_ZSTD_TRAIN_BYTES = "rocksdb.compression_zstd_max_train_bytes";
+  const std::string PROP_COMPRESSION_ZSTD_TRAIN_BYTES_DEFAULT = "0";
+
   const std::string PROP_MAX_BG_JOBS = "rocksdb.max_background_jobs";
   const std::string PROP_MAX_BG_JOBS_DEFAULT = "8";
 
@@ -70,6 +154,58 @@ namespace {
   const std::string PROP_L0_STOP_TRIGGER = "rocksdb.level0_stop_writes_trigger";
   const std::string PROP_L0_STOP_TRIGGER_DEFAULT = "0";
 
+  const std::string PROP_ENABLE_BLOB_FILES = "rocksdb.enable_blob_files";
+  const std::string PROP_ENABLE_BLOB_FILES_DEFAULT = "false";
+
+  const std::string PROP_MIN_BLOB_SIZE = "rocksdb.min_blob_size";
+  const std::string PROP_MIN_BLOB_SIZE_DEFAULT = "0";
+
+  const std::string PROP_BLOB_FILE_SIZE = "rocksdb.blob_file_size";
+  const std::string PROP_BLOB_FILE_SIZE_DEFAULT = "0";
+
+  const std::string PROP_BLOB_COMPRESSION = "rocksdb.blob_compression_type";
+  const std::string PROP_BLOB_COMPRESSION_DEFAULT = "no";
+
+  const std::string PROP_BLOB_FILE_STARTING_LEVEL = "rocksdb.blob_file_starting_level";
+  const std::string PROP_BLOB_FILE_STARTING_LEVEL_DEFAULT = "0";
+
+  const std::string PROP_BLOB_GC = "rocksdb.enable_blob_garbage_collection";
+  const std::string PROP_BLOB_GC_DEFAULT = "false";
+
+  const std::string PROP_BLOB_GC_AGE_CUTOFF = "rocksdb.blob_garbage_collection_age_cutoff";
+  const std::string PROP_BLOB_GC_AGE_CUTOFF_DEFAULT = "0.25";
+
+  const std::string PROP_BLOB_GC_FORCE_THRESHOLD = "rocksdb.blob_garbage_collection_force_threshold";
+  const std::string PROP_BLOB_GC_FORCE_THRESHOLD_DEFAULT = "1.0";
+
+  const std::string PROP_BLOB_READAHEAD = "rocksdb.blob_compaction_readahead_size";
+  const std::string PROP_BLOB_READAHEAD_DEFAULT = "0";
+
+  const std::string PROP_MAX_SUBCOMPACTIONS = "rocksdb.max_subcompactions";
+  const std::string PROP_MAX_SUBCOMPACTIONS_DEFAULT = "0";
+
+  const std::string PROP_BYTES_PER_SYNC = "rocksdb.bytes_per_sync";
+  const std::string PROP_BYTES_PER_SYNC_DEFAULT = "0";
+
+  const std::string PROP_WAL_BYTES_PER_SYNC = "rocksdb.wal_bytes_per_sync";
+  const std::string PROP_WAL_BYTES_PER_SYNC_DEFAULT = "0";
+
+  // applied over the options file too, which cannot describe a rate limiter
+  const std::string PROP_RATE_LIMIT = "rocksdb.rate_limiter.bytes_per_sec";
+  const std::string PROP_RATE_LIMIT_DEFAULT = "0";
+
+  const std::string PROP_RATE_LIMIT_AUTO_TUNE = "rocksdb.rate_limiter.auto_tuned";
+  const std::string PROP_RATE_LIMIT_AUTO_TUNE_DEFAULT = "false";
+
+  const std::string PROP_RATE_LIMIT_REFILL_US = "rocksdb.rate_limiter.refill_period_us";
+  const std::string PROP_RATE_LIMIT_REFILL_US_DEFAULT = "100000";
+
+  const std::string PROP_RATE_LIMIT_FAIRNESS = "rocksdb.rate_limiter.fairness";
+  const std::string PROP_RATE_LIMIT_FAIRNESS_DEFAULT = "10";
+
+  const std::string PROP_RATE_LIMIT_MODE = "rocksdb.rate_limiter.mode";
+  const std::string PROP_RATE_LIMIT_MODE_DEFAULT = "writes";
+
   const std::string PROP_USE_DIRECT_WRITE = "rocksdb.use_direct_io_for_flush_compaction";
   const std::string PROP_USE_DIRECT_WRITE_DEFAULT = "true";
 
@@ -85,12 +221,66 @@ namespace {
   const std::string PROP_CACHE_SIZE = "rocksdb.cache_size";
   const std::string PROP_CACHE_SIZE_DEFAULT = "1024";
 
+  const std::string PROP_CACHE_TYPE = "rocksdb.cache_type";
+  const std::string PROP_CACHE_TYPE_DEFAULT = "lru";
+
+  const std::string PROP_HYPERCLOCK_ENTRY_CHARGE = "rocksdb.hyperclock.estimated_entry_charge";
+  const std::string PROP_HYPERCLOCK_ENTRY_CHARGE_DEFAULT = "0";
+
+  const std::string PROP_CACHE_STATS = "rocksdb.cache_stats";
+  const std::string PROP_CACHE_STATS_DEFAULT = "false";
+
   const std::string PROP_COMPRESSED_CACHE_SIZE = "rocksdb.compressed_cache_size";
   const std::string PROP_COMPRESSED_CACHE_SIZE_DEFAULT = "0";
 
+  const std::string PROP_COMPRESSED_CACHE_COMPRESSION = "rocksdb.compressed_cache_compression";
+  const std::string PROP_COMPRESSED_CACHE_COMPRESSION_DEFAULT = "lz4";
+
   const std::string PROP_BLOOM_BITS = "rocksdb.bloom_bits";
   const std::string PROP_BLOOM_BITS_DEFAULT = "10";
 
+  const std::string PROP_FILTER_POLICY = "rocksdb.filter_policy";
+  const std::string PROP_FILTER_POLICY_DEFAULT = "bloom";
+
+  const std::string PROP_RIBBON_BLOOM_BEFORE_LEVEL = "rocksdb.ribbon_bloom_before_level";
+  const std::string PROP_RIBBON_BLOOM_BEFORE_LEVEL_DEFAULT = "0";
+
+  const std::string PROP_TABLE_FORMAT = "rocksdb.table_format";
+  const std::string PROP_TABLE_FORMAT_DEFAULT = "block";
+
+  const std::string PROP_PREFIX_LENGTH = "rocksdb.prefix_length";
+  const std::string PROP_PREFIX_LENGTH_DEFAULT = "0";
+
+  const std::string PROP_BLOCK_SIZE = "rocksdb.block_size";
+  const std::string PROP_BLOCK_SIZE_DEFAULT = "0";
+
+  const std::string PROP_INDEX_TYPE = "rocksdb.index_type";
+  const std::string PROP_INDEX_TYPE_DEFAULT = "binary";
+
+  const std::string PROP_PARTITION_FILTERS = "rocksdb.partition_filters";
+  const std::string PROP_PARTITION_FILTERS_DEFAULT = "false";
+
+  const std::string PROP_DATA_BLOCK_INDEX_TYPE = "rocksdb.data_block_index_type";
+  const std::string PROP_DATA_BLOCK_INDEX_TYPE_DEFAULT = "binary";
+
+  const std::string PROP_DATA_BLOCK_HASH_RATIO = "rocksdb.data_block_hash_table_util_ratio";
+  const std::string PROP_DATA_BLOCK_HASH_RATIO_DEFAULT = "0.75";
+
+  const std::string PROP_CACHE_INDEX_AND_FILTER = "rocksdb.cache_index_and_filter_blocks";
+  const std::string PROP_CACHE_INDEX_AND_FILTER_DEFAULT = "true";
+
+  const std::string PROP_PIN_L0_INDEX_AND_FILTER = "rocksdb.pin_l0_filter_and_index_blocks_in_cache";
+  const std::string PROP_PIN_L0_INDEX_AND_FILTER_DEFAULT = "false";
+
+  const std::string PROP_PLAIN_USER_KEY_LEN = "rocksdb.plain.user_key_len";
+  const std::string PROP_PLAIN_USER_KEY_LEN_DEFAULT = "0";
+
+  const std::string PROP_PLAIN_HASH_RATIO = "rocksdb.plain.hash_table_ratio";
+  const std::string PROP_PLAIN_HASH_RATIO_DEFAULT = "0.75";
+
+  const std::string PROP_PLAIN_INDEX_SPARSENESS = "rocksdb.plain.index_sparseness";
+  const std::string PROP_PLAIN_INDEX_SPARSENESS_DEFAULT = "16";
+
   const std::string PROP_INCREASE_PARALLELISM = "rocksdb.increase_parallelism";
   const std::string PROP_INCREASE_PARALLELISM_DEFAULT = "false";
 
@@ -108,58 +298,360 @@ namespace {
 
   static std::shared_ptr<rocksdb::Env> env_guard;
   static std::shared_ptr<rocksdb::Cache> block_cache;
-  static std::shared_ptr<rocksdb::Cache> block_cache_compressed;
+  static std::shared_ptr<rocksdb::Statistics> statistics;
+  static std::shared_ptr<rocksdb::RateLimiter> rate_limiter;
+  static std::string db_write_mode; // the write path options the DB was opened with
+
+  // the blob files of every table, read while the DB is open: the last Cleanup closes it
+  // before the run phase is reported
+  struct BlobFileStats {
+    uint64_t files = 0;
+    uint64_t total_size = 0;
+    uint64_t live_size = 0;
+    uint64_t garbage_size = 0;
+  };
+  static bool blob_files_enabled = false;
+  static BlobFileStats closed_blob_stats;
+
+  BlobFileStats ReadBlobFileStats(rocksdb::DB *db,
+                                  const std::vector<rocksdb::ColumnFamilyHandle *> &cf_handles) {
+    BlobFileStats stats;
+    const std::vector<rocksdb::ColumnFamilyHandle *> cfs = cf_handles.empty() ?
+        std::vector<rocksdb::ColumnFamilyHandle *>{db->DefaultColumnFamily()} : cf_handles;
+    for (rocksdb::ColumnFamilyHandle *cf : cfs) {
+      uint64_t value;
+      if (db->GetIntProperty(cf, rocksdb::DB::Properties::kNumBlobFiles, &value)) {
+        stats.files += value;
+      }
+      if (db->GetIntProperty(cf, rocksdb::DB::Properties::kTotalBlobFileSize, &value)) {
+        stats.total_size += value;
+      }
+      if (db->GetIntProperty(cf, rocksdb::DB::Properties::kLiveBlobFileSize, &value)) {
+        stats.live_size += value;
+      }
+      if (db->GetIntProperty(cf, rocksdb::DB::Properties::kLiveBlobFileGarbageSize, &value)) {
+        stats.garbage_size += value;
+      }
+    }
+    return stats;
+  }
+
+  rocksdb::CompressionType CompressionFromString(const std::string &name) {
+    if (name == "no") {
+      return rocksdb::kNoCompression;
+    } else if (name == "snappy") {
+      return rocksdb::kSnappyCompression;
+    } else if (name == "zlib") {
+      return rocksdb::kZlibCompression;
+    } else if (name == "bzip2") {
+      return rocksdb::kBZip2Compression;
+    } else if (name == "lz4") {
+      return rocksdb::kLZ4Compression;
+    } else if (name == "lz4hc") {
+      return rocksdb::kLZ4HCCompression;
+    } else if (name == "xpress") {
+      return rocksdb::kXpressCompression;
+    } else if (name == "zstd") {
+      return rocksdb::kZSTD;
+    } else {
+      throw utils::Exception("Unknown compression type: " + name);
+    }
+  }
+
+  rocksdb::BlockBasedTableOptions::IndexType IndexTypeFromString(const std::string &name) {
+    if (name == "binary") {
+      return rocksdb::BlockBasedTableOptions::kBinarySearch;
+    } else if (name == "hash") {
+      return rocksdb::BlockBasedTableOptions::kHashSearch;
+    } else if (name == "partitioned") {
+      return rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+    } else if (name == "binary_with_first_key") {
+      return rocksdb::BlockBasedTableOptions::kBinarySearchWithFirstKey;
+    } else {
+      throw utils::Exception("Unknown index type: " + name);
+    }
+  }
+
+  rocksdb::BlockBasedTableOptions::DataBlockIndexType DataBlockIndexTypeFromString(
+      const std::string &name) {
+    if (name == "binary") {
+      return rocksdb::BlockBasedTableOptions::kDataBlockBinarySearch;
+    } else if (name == "binary_and_hash") {
+      return rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+    } else {
+      throw utils::Exception("Unknown data block index type: " + name);
+    }
+  }
+
+  rocksdb::RateLimiter::Mode RateLimiterModeFromString(const std::string &name) {
+    if (name == "writes") {
+      return rocksdb::RateLimiter::Mode::kWritesOnly;
+    } else if (name == "reads") {
+      return rocksdb::RateLimiter::Mode::kReadsOnly;
+    } else if (name == "all") {
+      return rocksdb::RateLimiter::Mode::kAllIo;
+    } else {
+      throw utils::Exception("Unknown rate limiter mode: " + name);
+    }
+  }
+
+  bool PhaseWriteOption(const ycsbc::utils::Properties &props, const std::string &phase,
+                        const std::string &name, const std::string &default_value) {
+    std::string prefix = "rocksdb.";
+    std::transform(phase.begin(), phase.end(), std::back_inserter(prefix), ::tolower);
+    return ycsbc::utils::StrToBool(props.GetProperty(prefix + "." + name,
+                                   props.GetProperty("rocksdb." + name, default_value)));
+  }
+
+  void SetBoolOption(const ycsbc::utils::Properties &props, const std::string &name,
+                     const std::string &default_value, bool *option) {
+    const std::string value = props.GetProperty(name, default_value);
+    if (value != "") {
+      *option = ycsbc::utils::StrToBool(value);
+    }
+  }
+
+  rocksdb::PerfLevel PerfLevelFromString(const std::string &name) {
+    if (name == "disable") {
+      return rocksdb::kDisable;
+    } else if (name == "count") {
+      return rocksdb::kEnableCount;
+    } else if (name == "time_except_mutex") {
+      return rocksdb::kEnableTimeExceptForMutex;
+    } else if (name == "time_and_cpu_except_mutex") {
+      return rocksdb::kEnableTimeAndCPUTimeExceptForMutex;
+    } else if (name == "time") {
+      return rocksdb::kEnableTime;
+    } else {
+      throw utils::Exception("Unknown perf level: " + name);
+    }
+  }
+
+  struct PerfCounter {
+    const char *name;
+    uint64_t rocksdb::PerfContext::*perf;        // one of perf and iostats is set
+    uint64_t rocksdb::IOStatsContext::*iostats;
+    bool brief;                                  // also on the status lines
+  };
+
+  const PerfCounter kPerfCounters[] = {
+    {"user_key_comparison_count", &rocksdb::PerfContext::user_key_comparison_count, nullptr, false},
+    {"block_cache_hit_count", &rocksdb::PerfContext::block_cache_hit_count, nullptr, true},
+    {"block_read_count", &rocksdb::PerfContext::block_read_count, nullptr, true},
+    {"block_read_byte", &rocksdb::PerfContext::block_read_byte, nullptr, false},
+    {"block_read_time", &rocksdb::PerfContext::block_read_time, nullptr, true},
+    {"block_checksum_time", &rocksdb::PerfContext::block_checksum_time, nullptr, false},
+    {"block_decompress_time", &rocksdb::PerfContext::block_decompress_time, nullptr, false},
+    {"get_snapshot_time", &rocksdb::PerfContext::get_snapshot_time, nullptr, false},
+    {"get_from_memtable_time", &rocksdb::PerfContext::get_from_memtable_time, nullptr, true},
+    {"get_from_memtable_count", &rocksdb::PerfContext::get_from_memtable_count, nullptr, false},
+    {"get_from_output_files_time", &rocksdb::PerfContext::get_from_output_files_time, nullptr, true},
+    {"bloom_memtable_hit_count", &rocksdb::PerfContext::bloom_memtable_hit_count, nullptr, false},
+    {"bloom_memtable_miss_count", &rocksdb::PerfContext::bloom_memtable_miss_count, nullptr, false},
+    {"bloom_sst_hit_count", &rocksdb::PerfContext::bloom_sst_hit_count, nullptr, false},
+    {"bloom_sst_miss_count", &rocksdb::PerfContext::bloom_sst_miss_count, nullptr, true},
+    {"seek_on_memtable_time", &rocksdb::PerfContext::seek_on_memtable_time, nullptr, false},
+    {"seek_child_seek_time", &rocksdb::PerfContext::seek_child_seek_time, nullptr, false},
+    {"seek_internal_seek_time", &rocksdb::PerfContext::seek_internal_seek_time, nullptr, false},
+    {"find_next_user_entry_time", &rocksdb::PerfContext::find_next_user_entry_time, nullptr, false},
+    {"internal_key_skipped_count", &rocksdb::PerfContext::internal_key_skipped_count, nullptr, false},
+    {"internal_delete_skipped_count", &rocksdb::PerfContext::internal_delete_skipped_count, nullptr, false},
+    {"write_wal_time", &rocksdb::PerfContext::write_wal_time, nullptr, true},
+    {"write_memtable_time", &rocksdb::PerfContext::write_memtable_time, nullptr, true},
+    {"write_delay_time", &rocksdb::PerfContext::write_delay_time, nullptr, true},
+    {"write_thread_wait_nanos", &rocksdb::PerfContext::write_thread_wait_nanos, nullptr, false},
+    {"write_pre_and_post_process_time", &rocksdb::PerfContext::write_pre_and_post_process_time, nullptr, false},
+    {"db_mutex_lock_nanos", &rocksdb::PerfContext::db_mutex_lock_nanos, nullptr, false},
+    {"db_condition_wait_nanos", &rocksdb::PerfContext::db_condition_wait_nanos, nullptr, false},
+    {"io.bytes_read", nullptr, &rocksdb::IOStatsContext::bytes_read, false},
+    {"io.bytes_written", nullptr, &rocksdb::IOStatsContext::bytes_written, false},
+    {"io.read_nanos", nullptr, &rocksdb::IOStatsContext::read_nanos, true},
+    {"io.write_nanos", nullptr, &rocksdb::IOStatsContext::write_nanos, false},
+    {"io.fsync_nanos", nullptr, &rocksdb::IOStatsContext::fsync_nanos, false},
+  };
+  constexpr size_t kNumPerfCounters = sizeof(kPerfCounters) / sizeof(kPerfCounters[0]);
+
+  // ops measured per type, up to RANGE_SCAN; slot 0 of each row counts the ops
+  constexpr size_t kPerfOps = ycsbc::INSERT_FAILED;
+  constexpr size_t kPerfRow = kNumPerfCounters + 1;
+
+  // the totals at the previous status line and at the end of the previous phase
+  std::vector<uint64_t> perf_status_base;
+  std::vector<uint64_t> perf_phase_base;
+  uint64_t cache_hit_base = 0;
+  uint64_t secondary_hit_base = 0;
+  uint64_t cache_miss_base = 0;
+  uint64_t stall_micros_base = 0;
+  // the tickers and rate limiter totals the phase reports count from the start of the phase
+  const rocksdb::Tickers kPhaseTickers[] = {
+    rocksdb::STALL_MICROS, rocksdb::NUMBER_RATE_LIMITER_DRAINS, rocksdb::BYTES_WRITTEN,
+    rocksdb::FLUSH_WRITE_BYTES, rocksdb::COMPACT_WRITE_BYTES,
+    rocksdb::BLOB_DB_BLOB_FILE_BYTES_WRITTEN, rocksdb::BLOB_DB_BLOB_FILE_BYTES_READ,
+    rocksdb::BLOB_DB_GC_NUM_KEYS_RELOCATED, rocksdb::BLOB_DB_GC_BYTES_RELOCATED,
+  };
+  constexpr size_t kNumPhaseTickers = sizeof(kPhaseTickers) / sizeof(kPhaseTickers[0]);
+  uint64_t phase_ticker_base[kNumPhaseTickers];
+  uint64_t phase_start_ns = 0;
+  int64_t phase_limited_bytes_base = 0;
+  int64_t phase_limited_requests_base = 0;
+
+  uint64_t PhaseTickerCount(const rocksdb::Statistics &stats, rocksdb::Tickers ticker) {
+    size_t i = std::find(std::begin(kPhaseTickers), std::end(kPhaseTickers), ticker) -
+               std::begin(kPhaseTickers);
+    return stats.getTickerCount(ticker) - phase_ticker_base[i];
+  }
+
+  // engine-side read latency by the merge operands the read applied: 0, 1, 2-3, ..., 32+
+  constexpr size_t kMergeBuckets = 7;
+  const char *const kMergeBucketString[kMergeBuckets] = {"0", "1", "2-3", "4-7", "8-15",
+                                                         "16-31", "32+"};
+  std::atomic<uint64_t> merge_read_count[kMergeBuckets];
+  std::atomic<uint64_t> merge_read_ns[kMergeBuckets];
+  std::atomic<uint64_t> merge_read_max_ns[kMergeBuckets];
+
+  uint64_t NowNs() {
+    return ycsbc::utils::TscClock::now().time_since_epoch().count();
+  }
+
+  void RecordMergeRead(size_t operands, uint64_t ns) {
+    size_t bucket = 0;
+    while (operands != 0 && bucket < kMergeBuckets - 1) {
+      operands >>= 1;
+      bucket++;
+    }
+    merge_read_count[bucket].fetch_add(1, std::memory_order_relaxed);
+    merge_read_ns[bucket].fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = merge_read_max_ns[bucket].load(std::memory_order_relaxed);
+    while (ns > max && !merge_read_max_ns[bucket].compare_exchange_weak(max, ns,
+                                                                         std::memory_order_relaxed)) {
+    }
+  }
+
+  // per-op averages of the counters grown since base
+  void FormatPerf(std::ostream &out, const std::vector<uint64_t> &totals,
+                  const std::vector<uint64_t> &base, bool brief) {
+    for (size_t op = 0; op < kPerfOps; op++) {
+      const uint64_t *row = &totals[op * kPerfRow];
+      const uint64_t *base_row = base.empty() ? nullptr : &base[op * kPerfRow];
+      uint64_t ops = row[0] - (base_row ? base_row[0] : 0);
+      if (ops == 0) {
+        continue;
+      }
+      if (brief) {
+        out << " [rocksdb " << ycsbc::kOperationString[op] << ":";
+      } else {
+        out << "  " << ycsbc::kOperationString[op] << " ops=" << ops << "\n";
+      }
+      for (size_t i = 0; i < kNumPerfCounters; i++) {
+        uint64_t sum = row[i + 1] - (base_row ? base_row[i + 1] : 0);
+        if (sum == 0 || (brief && !kPerfCounters[i].brief)) {
+          continue;
+        }
+        if (brief) {
+          out << " " << kPerfCounters[i].name << "=" << static_cast<double>(sum) / ops;
+        } else {
+          out << "    " << std::left << std::setw(36) << kPerfCounters[i].name << std::right
+              << std::setw(14) << static_cast<double>(sum) / ops << "\n";
+        }
+      }
+      if (brief) {
+        out << "]";
+      }
+    }
+  }
+
+  rocksdb::WideColumns ToColumns(const std::vector<ycsbc::DB::Field> &values) {
+    rocksdb::WideColumns columns;
+    columns.reserve(values.size());
+    for (const ycsbc::DB::Field &field : values) {
+      columns.emplace_back(field.name, field.value);
+    }
+    return columns;
+  }
+
+  // RocksDB keeps the columns of an entity sorted by name, so a projection looks each
+  // field up instead of walking the row
+  void AppendColumns(const rocksdb::WideColumns &columns, const std::vector<std::string> *fields,
+                     std::vector<ycsbc::DB::Field> &result) {
+    if (fields == nullptr) {
+      for (const rocksdb::WideColumn &column : columns) {
+        result.push_back({column.name().ToString(), column.value().ToString()});
+      }
+      return;
+    }
+    for (const std::string &field : *fields) {
+      auto it = std::lower_bound(columns.begin(), columns.end(), field,
+                                 [](const rocksdb::WideColumn &column, const std::string &name) {
+                                   return column.name().compare(name) < 0;
+                                 });
+      if (it != columns.end() && it->name() == field) {
+        result.push_back({field, it->value().ToString()});
+      }
+    }
+  }
 } // anonymous
 
 namespace ycsbc {
 
 rocksdb::DB *RocksdbDB::db_ = nullptr;
+std::vector<rocksdb::ColumnFamilyHandle *> RocksdbDB::cf_handles_;
+std::vector<std::string> RocksdbDB::table_names_;
+std::vector<rocksdb::ColumnFamilyHandle *> RocksdbDB::table_cf_;
 int RocksdbDB::ref_cnt_ = 0;
 std::mutex RocksdbDB::mu_;
+std::vector<std::shared_ptr<RocksdbDB::PerfStats>> RocksdbDB::perf_stats_;
+rocksdb::WriteOptions RocksdbDB::write_options_;
+
+///
+/// PerfContext and IOStatsContext counters of one instance, summed per op type.
+/// Atomic because the default async ops may run one instance on several threads.
+///
+struct RocksdbDB::PerfStats {
+  explicit PerfStats(rocksdb::PerfLevel level) : level(level) {}
+
+  const rocksdb::PerfLevel level;
+  std::atomic<uint64_t> counts[kPerfOps][kPerfRow] = {};
+};
+
+///
+/// Resets the calling thread's contexts for one op, or a batch of ops, and adds
+/// what they counted to the instance's totals when it goes out of scope.
+///
+class RocksdbDB::PerfScope {
+ public:
+  PerfScope(PerfStats *stats, Operation op, uint64_t ops = 1) : stats_(stats), op_(op), ops_(ops) {
+    if (stats_ != nullptr) {
+      // the level is per thread, and a phase may run the instance on a new thread
+      rocksdb::SetPerfLevel(stats_->level);
+      rocksdb::get_perf_context()->Reset();
+      rocksdb::get_iostats_context()->Reset();
+    }
+  }
 
-void RocksdbDB::Init() {
-// merge operator disabled by default due to link error
-#ifdef USE_MERGEUPDATE
-  class YCSBUpdateMerge : public rocksdb::AssociativeMergeOperator {
-   public:
-    virtual bool Merge(const rocksdb::Slice &key, const rocksdb::Slice *existing_value,
-                       const rocksdb::Slice &value, std::string *new_value,
-                       rocksdb::Logger *logger) const override {
-      assert(existing_value);
-
-      std::vector<Field> values;
-      const char *p = existing_value->data();
-      const char *lim = p + existing_value->size();
-      DeserializeRow(values, p, lim);
-
-      std::vector<Field> new_values;
-      p = value.data();
-      lim = p + value.size();
-      DeserializeRow(new_values, p, lim);
-
-      for (Field &new_field : new_values) {
-        bool found = false;
-        for (Field &field : values) {
-          if (field.name == new_field.name) {
-            found = true;
-            field.value = new_field.value;
-            break;
-          }
-        }
-        if (!found) {
-          values.push_back(new_field);
-        }
+  ~PerfScope() {
+    if (stats_ == nullptr) {
+      return;
+    }
+    const rocksdb::PerfContext &perf = *rocksdb::get_perf_context();
+    const rocksdb::IOStatsContext &iostats = *rocksdb::get_iostats_context();
+    std::atomic<uint64_t> *row = stats_->counts[op_];
+    row[0].fetch_add(ops_, std::memory_order_relaxed);
+    for (size_t i = 0; i < kNumPerfCounters; i++) {
+      const PerfCounter &counter = kPerfCounters[i];
+      uint64_t value = counter.perf != nullptr ? perf.*counter.perf : iostats.*counter.iostats;
+      if (value != 0) {
+        row[i + 1].fetch_add(value, std::memory_order_relaxed);
       }
-
-      SerializeRow(values, *new_value);
-      return true;
     }
+  }
 
-    virtual const char *Name() const override {
-      return "YCSBUpdateMerge";
-    }
-  };
-#endif
+ private:
+  PerfStats *stats_;
+  Operation op_;
+  uint64_t ops_;
+};
+
+void RocksdbDB::Init() {
   const std::lock_guard<std::mutex> lock(mu_);
 
   const utils::Properties &props = *props_;
@@ -168,19 +660,89 @@ void RocksdbDB::Init() {
     format_ = kSingleRow;
     method_read_ = &RocksdbDB::ReadSingle;
     method_scan_ = &RocksdbDB::ScanSingle;
+    method_reverse_scan_ = &RocksdbDB::ReverseScanSingle;
+    method_range_scan_ = &RocksdbDB::RangeScanSingle;
     method_update_ = &RocksdbDB::UpdateSingle;
     method_insert_ = &RocksdbDB::InsertSingle;
     method_delete_ = &RocksdbDB::DeleteSingle;
-#ifdef USE_MERGEUPDATE
-    if (props.GetProperty(PROP_MERGEUPDATE, PROP_MERGEUPDATE_DEFAULT) == "true") {
+    merge_update_ = props.GetProperty(PROP_MERGEUPDATE, PROP_MERGEUPDATE_DEFAULT) == "true";
+    if (merge_update_) {
       method_update_ = &RocksdbDB::MergeSingle;
     }
-#endif
+  } else if (format == "row") {
+    format_ = kRowMajor;
+    method_read_ = &RocksdbDB::ReadCompKeyRM;
+    method_scan_ = &RocksdbDB::ScanCompKeyRM;
+    method_reverse_scan_ = &RocksdbDB::ReverseScanCompKeyRM;
+    method_range_scan_ = &RocksdbDB::RangeScanCompKeyRM;
+    method_update_ = &RocksdbDB::UpdateCompKey;
+    method_insert_ = &RocksdbDB::InsertCompKey;
+    method_delete_ = &RocksdbDB::DeleteCompKey;
+  } else if (format == "column") {
+    format_ = kColumnMajor;
+    method_read_ = &RocksdbDB::ReadCompKeyCM;
+    method_scan_ = &RocksdbDB::ScanCompKeyCM;
+    method_reverse_scan_ = &RocksdbDB::ReverseScanCompKeyCM;
+    method_range_scan_ = &RocksdbDB::RangeScanCompKeyCM;
+    method_update_ = &RocksdbDB::UpdateCompKey;
+    method_insert_ = &RocksdbDB::InsertCompKey;
+    method_delete_ = &RocksdbDB::DeleteCompKey;
+  } else if (format == "wide") {
+    format_ = kWideColumn;
+    method_read_ = &RocksdbDB::ReadWide;
+    method_scan_ = &RocksdbDB::ScanWide;
+    method_reverse_scan_ = &RocksdbDB::ReverseScanWide;
+    method_range_scan_ = &RocksdbDB::RangeScanWide;
+    method_update_ = &RocksdbDB::UpdateWide;
+    method_insert_ = &RocksdbDB::InsertWide;
+    method_delete_ = &RocksdbDB::DeleteSingle;
   } else {
     throw utils::Exception("unknown format");
   }
+  if (format_ != kSingleRow && props.GetProperty(PROP_MERGEUPDATE, PROP_MERGEUPDATE_DEFAULT) == "true") {
+    throw utils::Exception("rocksdb.mergeupdate needs rocksdb.format=single");
+  }
   fieldcount_ = std::stoi(props.GetProperty(CoreWorkload::FIELD_COUNT_PROPERTY,
                                             CoreWorkload::FIELD_COUNT_DEFAULT));
+  const std::string field_prefix = props.GetProperty(CoreWorkload::FIELD_NAME_PREFIX,
+                                                     CoreWorkload::FIELD_NAME_PREFIX_DEFAULT);
+  field_names_.clear();
+  for (int i = 0; i < fieldcount_; i++) {
+    field_names_.push_back(field_prefix + std::to_string(i));
+  }
+  codec_ = RowCodec::FromProperties(props);
+  async_io_ = props.GetProperty(PROP_ASYNC_IO, PROP_ASYNC_IO_DEFAULT) == "true";
+
+  cache_iterators_ = props.GetProperty(PROP_CACHE_ITERATORS, PROP_CACHE_ITERATORS_DEFAULT) == "true";
+  scan_options_.readahead_size = std::stoul(props.GetProperty(PROP_SCAN_READAHEAD,
+                                                              PROP_SCAN_READAHEAD_DEFAULT));
+  scan_options_.pin_data = props.GetProperty(PROP_SCAN_PIN_DATA, PROP_SCAN_PIN_DATA_DEFAULT) == "true";
+  scan_options_.auto_prefix_mode = props.GetProperty(PROP_SCAN_AUTO_PREFIX,
+                                                     PROP_SCAN_AUTO_PREFIX_DEFAULT) == "true";
+  // with a prefix extractor a plain Seek only promises the keys of the same prefix;
+  // PlainTable's prefix hash has no total order, its scans stay within a prefix
+  if (std::stoul(props.GetProperty(PROP_PREFIX_LENGTH, PROP_PREFIX_LENGTH_DEFAULT)) > 0 &&
+      props.GetProperty(PROP_TABLE_FORMAT, PROP_TABLE_FORMAT_DEFAULT) == "block" &&
+      !scan_options_.auto_prefix_mode) {
+    scan_options_.total_order_seek = true;
+  }
+  range_options_ = scan_options_;
+  // a fixed bound for scans, e.g. the end of the loaded key space
+  scan_upper_bound_ = props.GetProperty(PROP_SCAN_UPPER_BOUND, PROP_SCAN_UPPER_BOUND_DEFAULT);
+  // a key bound means nothing to column-major keys, which start with the field name
+  if (!scan_upper_bound_.empty() && format_ != kColumnMajor) {
+    scan_upper_bound_slice_ = scan_upper_bound_;
+    scan_options_.iterate_upper_bound = &scan_upper_bound_slice_;
+  }
+  // iterators only dereference the bound when they seek and advance, so a cached one
+  // follows range_upper_bound_ as RangeScan moves it
+  range_options_.iterate_upper_bound = &range_upper_bound_;
+  rocksdb::PerfLevel perf_level = PerfLevelFromString(props.GetProperty(PROP_PERF_LEVEL,
+                                                                        PROP_PERF_LEVEL_DEFAULT));
+  if (perf_level != rocksdb::kDisable && perf_ == nullptr) {
+    perf_ = std::make_shared<PerfStats>(perf_level);
+    perf_stats_.push_back(perf_);
+  }
 
   ref_cnt_++;
   if (db_) {
@@ -195,11 +757,33 @@ void RocksdbDB::Init() {
   rocksdb::Options opt;
   opt.create_if_missing = true;
   std::vector<rocksdb::ColumnFamilyDescriptor> cf_descs;
-  std::vector<rocksdb::ColumnFamilyHandle *> cf_handles;
   GetOptions(props, &opt, &cf_descs);
-#ifdef USE_MERGEUPDATE
-  opt.merge_operator.reset(new YCSBUpdateMerge);
-#endif
+  // installed even without mergeupdate, so a DB holding merge operands stays readable
+  opt.merge_operator = NewFieldMergeOperator(codec_);
+  for (rocksdb::ColumnFamilyDescriptor &desc : cf_descs) {
+    desc.options.merge_operator = opt.merge_operator;
+  }
+
+  // one column family per table; a single table keeps using the default column family
+  const std::vector<std::string> tables = CoreWorkload::TableNames(props);
+  if (tables.size() > 1) {
+    opt.create_missing_column_families = true;
+    if (cf_descs.empty()) {
+      cf_descs.emplace_back(rocksdb::kDefaultColumnFamilyName, rocksdb::ColumnFamilyOptions(opt));
+    }
+    for (const std::string &table : tables) {
+      bool found = false;
+      for (const rocksdb::ColumnFamilyDescriptor &desc : cf_descs) {
+        if (desc.name == table) {
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        cf_descs.emplace_back(table, rocksdb::ColumnFamilyOptions(opt));
+      }
+    }
+  }
 
   rocksdb::Status s;
   if (props.GetProperty(PROP_DESTROY, PROP_DESTROY_DEFAULT) == "true") {
@@ -211,19 +795,80 @@ void RocksdbDB::Init() {
   if (cf_descs.empty()) {
     s = rocksdb::DB::Open(opt, db_path, &db_);
   } else {
-    s = rocksdb::DB::Open(opt, db_path, cf_descs, &cf_handles, &db_);
+    s = rocksdb::DB::Open(opt, db_path, cf_descs, &cf_handles_, &db_);
   }
   if (!s.ok()) {
     throw utils::Exception(std::string("RocksDB Open: ") + s.ToString());
   }
+  table_names_ = tables;
+  table_cf_.assign(tables.size(), nullptr);
+  for (size_t i = 0; i < cf_handles_.size(); i++) {
+    int table = CoreWorkload::TableNumber(tables, cf_descs[i].name);
+    if (table >= 0) {
+      table_cf_[table] = cf_handles_[i];
+    }
+  }
+
+  const rocksdb::DBOptions db_options = db_->GetDBOptions();
+  std::ostringstream mode;
+  mode << std::boolalpha
+       << "enable_pipelined_write=" << db_options.enable_pipelined_write
+       << " unordered_write=" << db_options.unordered_write
+       << " allow_concurrent_memtable_write=" << db_options.allow_concurrent_memtable_write
+       << " two_write_queues=" << db_options.two_write_queues;
+  db_write_mode = mode.str();
+  blob_files_enabled = db_->GetOptions().enable_blob_files;
+}
+
+void RocksdbDB::PhaseBegin(const std::string &phase) {
+  const utils::Properties &props = *props_;
+  rocksdb::WriteOptions options;
+  options.disableWAL = PhaseWriteOption(props, phase, PROP_WRITE_DISABLE_WAL,
+                                        PROP_WRITE_DISABLE_WAL_DEFAULT);
+  options.sync = PhaseWriteOption(props, phase, PROP_WRITE_SYNC, PROP_WRITE_SYNC_DEFAULT);
+  options.no_slowdown = PhaseWriteOption(props, phase, PROP_WRITE_NO_SLOWDOWN,
+                                         PROP_WRITE_NO_SLOWDOWN_DEFAULT);
+  options.low_pri = PhaseWriteOption(props, phase, PROP_WRITE_LOW_PRI, PROP_WRITE_LOW_PRI_DEFAULT);
+  if (options.sync && options.disableWAL) {
+    throw utils::Exception("RocksDB " + phase + " phase: sync writes need the WAL");
+  }
+  // the client threads start after this returns, so they see the new options
+  write_options_ = options;
+
+  std::shared_ptr<rocksdb::Statistics> stats;
+  std::shared_ptr<rocksdb::RateLimiter> limiter;
+  {
+    const std::lock_guard<std::mutex> lock(mu_);
+    stats = statistics;
+    limiter = rate_limiter;
+  }
+  phase_start_ns = NowNs();
+  for (size_t i = 0; i < kNumPhaseTickers; i++) {
+    phase_ticker_base[i] = stats != nullptr ? stats->getTickerCount(kPhaseTickers[i]) : 0;
+  }
+  phase_limited_bytes_base = limiter != nullptr ? limiter->GetTotalBytesThrough() : 0;
+  phase_limited_requests_base = limiter != nullptr ? limiter->GetTotalRequests() : 0;
 }
 
 void RocksdbDB::Cleanup() {
+  // iterators must go before the DB does
+  scan_iterators_.clear();
+  range_iterators_.clear();
   const std::lock_guard<std::mutex> lock(mu_);
   if (--ref_cnt_) {
     return;
   }
+  if (blob_files_enabled) {
+    closed_blob_stats = ReadBlobFileStats(db_, cf_handles_);
+  }
+  for (rocksdb::ColumnFamilyHandle *cf : cf_handles_) {
+    db_->DestroyColumnFamilyHandle(cf);
+  }
+  cf_handles_.clear();
+  table_cf_.clear();
+  table_names_.clear();
   delete db_;
+  db_ = nullptr;
 }
 
 void RocksdbDB::GetOptions(const utils::Properties &props, rocksdb::Options *opt,
@@ -241,33 +886,46 @@ void RocksdbDB::GetOptions(const utils::Properties &props, rocksdb::Options *opt
   }
 
   const std::string options_file = props.GetProperty(PROP_OPTIONS_FILE, PROP_OPTIONS_FILE_DEFAULT);
-  // if (options_file != "") {
-  //   rocksdb::Status s = rocksdb::LoadOptionsFromFile(options_file, env, opt, cf_descs);
-  //   if (!s.ok()) {
-  //     throw utils::Exception(std::string("RocksDB LoadOptionsFromFile: ") + s.ToString());
-  //   }
-  // } else {
-    const std::string compression_type = props.GetProperty(PROP_COMPRESSION,
-                                                           PROP_COMPRESSION_DEFAULT);
-    //if (compression_type == "no") {
-      opt->compression = rocksdb::kNoCompression;
-    // } else if (compression_type == "snappy") {
-    //   opt->compression = rocksdb::kSnappyCompression;
-    // } else if (compression_type == "zlib") {
-    //   opt->compression = rocksdb::kZlibCompression;
-    // } else if (compression_type == "bzip2") {
-    //   opt->compression = rocksdb::kBZip2Compression;
-    // } else if (compression_type == "lz4") {
-    //   opt->compression = rocksdb::kLZ4Compression;
-    // } else if (compression_type == "lz4hc") {
-    //   opt->compression = rocksdb::kLZ4HCCompression;
-    // } else if (compression_type == "xpress") {
-    //   opt->compression = rocksdb::kXpressCompression;
-    // } else if (compression_type == "zstd") {
-    //   opt->compression = rocksdb::kZSTD;
-    // } else {
-    //   throw utils::Exception("Unknown compression type");
-    // }
+  if (options_file != "") {
+    rocksdb::ConfigOptions config_options;
+    config_options.env = env;
+    rocksdb::Status s = rocksdb::LoadOptionsFromFile(config_options, options_file, opt, cf_descs);
+    if (!s.ok()) {
+      throw utils::Exception(std::string("RocksDB LoadOptionsFromFile: ") + s.ToString());
+    }
+    opt->create_if_missing = true;
+    opt->env = env;
+    // tables without a section of their own start from the default column family options
+    for (const rocksdb::ColumnFamilyDescriptor &desc : *cf_descs) {
+      if (desc.name == rocksdb::kDefaultColumnFamilyName) {
+        *static_cast<rocksdb::ColumnFamilyOptions *>(opt) = desc.options;
+      }
+    }
+  } else {
+    opt->compression = CompressionFromString(props.GetProperty(PROP_COMPRESSION,
+                                                               PROP_COMPRESSION_DEFAULT));
+    // e.g. "no,no,lz4,lz4,lz4,zstd,zstd"; levels past the list use its last entry
+    const std::vector<std::string> per_level = utils::Split(
+        props.GetProperty(PROP_COMPRESSION_PER_LEVEL, PROP_COMPRESSION_PER_LEVEL_DEFAULT), ',');
+    for (const std::string &name : per_level) {
+      opt->compression_per_level.push_back(CompressionFromString(utils::Trim(name)));
+    }
+    const std::string bottommost = props.GetProperty(PROP_BOTTOMMOST_COMPRESSION,
+                                                     PROP_BOTTOMMOST_COMPRESSION_DEFAULT);
+    if (bottommost != "") {
+      opt->bottommost_compression = CompressionFromString(bottommost);
+    }
+    const std::string level = props.GetProperty(PROP_COMPRESSION_LEVEL, PROP_COMPRESSION_LEVEL_DEFAULT);
+    if (level != "") {
+      opt->compression_opts.level = std::stoi(level);
+    }
+    // a dictionary per SST file, trained with zstd when zstd_max_train_bytes is set
+    opt->compression_opts.max_dict_bytes = std::stoul(
+        props.GetProperty(PROP_COMPRESSION_MAX_DICT_BYTES, PROP_COMPRESSION_MAX_DICT_BYTES_DEFAULT));
+    opt->compression_opts.zstd_max_train_bytes = std::stoul(
+        props.GetProperty(PROP_COMPRESSION_ZSTD_TRAIN_BYTES, PROP_COMPRESSION_ZSTD_TRAIN_BYTES_DEFAULT));
+    opt->bottommost_compression_opts = opt->compression_opts;
+    opt->bottommost_compression_opts.enabled = true;
 
     int val = std::stoi(props.GetProperty(PROP_MAX_BG_JOBS, PROP_MAX_BG_JOBS_DEFAULT));
     if (val != 0) {
@@ -314,6 +972,54 @@ void RocksdbDB::GetOptions(const utils::Properties &props, rocksdb::Options *opt
     if (val != 0) {
       opt->level0_stop_writes_trigger = val;
     }
+    // key-value separation: values of min_blob_size and up go to blob files as flushes
+    // and compactions write them, the SSTs keep a reference
+    opt->enable_blob_files = props.GetProperty(PROP_ENABLE_BLOB_FILES,
+                                               PROP_ENABLE_BLOB_FILES_DEFAULT) == "true";
+    opt->min_blob_size = std::stoull(props.GetProperty(PROP_MIN_BLOB_SIZE,
+                                                       PROP_MIN_BLOB_SIZE_DEFAULT));
+    uint64_t blob_file_size = std::stoull(props.GetProperty(PROP_BLOB_FILE_SIZE,
+                                                            PROP_BLOB_FILE_SIZE_DEFAULT));
+    if (blob_file_size != 0) {
+      opt->blob_file_size = blob_file_size;
+    }
+    opt->blob_compression_type = CompressionFromString(props.GetProperty(PROP_BLOB_COMPRESSION,
+                                                                         PROP_BLOB_COMPRESSION_DEFAULT));
+    opt->blob_file_starting_level = std::stoi(props.GetProperty(PROP_BLOB_FILE_STARTING_LEVEL,
+                                                                PROP_BLOB_FILE_STARTING_LEVEL_DEFAULT));
+    // compactions rewrite the live blobs of the oldest age_cutoff of the blob files, and
+    // are forced on files whose garbage ratio passes force_threshold
+    opt->enable_blob_garbage_collection = props.GetProperty(PROP_BLOB_GC, PROP_BLOB_GC_DEFAULT) == "true";
+    opt->blob_garbage_collection_age_cutoff = std::stod(props.GetProperty(PROP_BLOB_GC_AGE_CUTOFF,
+                                                                          PROP_BLOB_GC_AGE_CUTOFF_DEFAULT));
+    opt->blob_garbage_collection_force_threshold = std::stod(
+        props.GetProperty(PROP_BLOB_GC_FORCE_THRESHOLD, PROP_BLOB_GC_FORCE_THRESHOLD_DEFAULT));
+    opt->blob_compaction_readahead_size = std::stoull(props.GetProperty(PROP_BLOB_READAHEAD,
+                                                                        PROP_BLOB_READAHEAD_DEFAULT));
+
+    // split a large compaction into ranges run in parallel
+    val = std::stoi(props.GetProperty(PROP_MAX_SUBCOMPACTIONS, PROP_MAX_SUBCOMPACTIONS_DEFAULT));
+    if (val != 0) {
+      opt->max_subcompactions = val;
+    }
+    // sync SST and WAL files every so many bytes instead of all at once when they close,
+    // so the OS never holds a burst of dirty pages to write back
+    uint64_t sync_bytes = std::stoull(props.GetProperty(PROP_BYTES_PER_SYNC,
+                                                        PROP_BYTES_PER_SYNC_DEFAULT));
+    if (sync_bytes != 0) {
+      opt->bytes_per_sync = sync_bytes;
+    }
+    sync_bytes = std::stoull(props.GetProperty(PROP_WAL_BYTES_PER_SYNC,
+                                               PROP_WAL_BYTES_PER_SYNC_DEFAULT));
+    if (sync_bytes != 0) {
+      opt->wal_bytes_per_sync = sync_bytes;
+    }
+    // past this many operands in the memtable a merge reads the key and writes the
+    // merged row instead, bounding the operands a read has to apply
+    val = std::stoi(props.GetProperty(PROP_MAX_SUCCESSIVE_MERGES, PROP_MAX_SUCCESSIVE_MERGES_DEFAULT));
+    if (val != 0) {
+      opt->max_successive_merges = val;
+    }
 
     if (props.GetProperty(PROP_USE_DIRECT_WRITE, PROP_USE_DIRECT_WRITE_DEFAULT) == "true") {
       opt->use_direct_io_for_flush_and_compaction = true;
@@ -328,25 +1034,114 @@ void RocksdbDB::GetOptions(const utils::Properties &props, rocksdb::Options *opt
       opt->allow_mmap_reads = true;
     }
 
-    rocksdb::LRUCacheOptions cache_options;
-    size_t cache_size = std::stoul(props.GetProperty(PROP_CACHE_SIZE, PROP_CACHE_SIZE_DEFAULT));
-    cache_options.capacity = cache_size * 1024 *1024;
-    rocksdb::BlockBasedTableOptions table_options;
-    // table_options.block_size = 4 * 1024;
-    // table_options.checksum = rocksdb::kNoChecksum;
-    table_options.block_cache = rocksdb::NewLRUCache(cache_options);
-    // size_t compressed_cache_size = std::stoul(props.GetProperty(PROP_COMPRESSED_CACHE_SIZE,
-    //                                                             PROP_COMPRESSED_CACHE_SIZE_DEFAULT));
-    // if (compressed_cache_size > 0) {
-    //   block_cache_compressed = rocksdb::NewLRUCache(compressed_cache_size);
-    //   table_options.block_cache_compressed = block_cache_compressed;
-    // }
-    table_options.cache_index_and_filter_blocks = true; // Important!!
+    // hash indexes, prefix filters and PlainTable's hash all index the key prefix
+    const size_t prefix_length = std::stoul(props.GetProperty(PROP_PREFIX_LENGTH,
+                                                              PROP_PREFIX_LENGTH_DEFAULT));
+    if (prefix_length > 0) {
+      opt->prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(prefix_length));
+    }
     int bloom_bits = std::stoul(props.GetProperty(PROP_BLOOM_BITS, PROP_BLOOM_BITS_DEFAULT));
-    if (bloom_bits > 0) {
-      table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bloom_bits));
+    const std::string table_format = props.GetProperty(PROP_TABLE_FORMAT, PROP_TABLE_FORMAT_DEFAULT);
+    if (table_format == "plain") {
+      // in-memory point lookups: no blocks and no block cache, the file is mmapped
+      if (opt->use_direct_reads) {
+        throw utils::Exception("RocksDB PlainTable needs mmap reads, not direct reads");
+      }
+      opt->allow_mmap_reads = true;
+      rocksdb::PlainTableOptions plain_options;
+      const uint32_t user_key_len = std::stoul(props.GetProperty(PROP_PLAIN_USER_KEY_LEN,
+                                                                 PROP_PLAIN_USER_KEY_LEN_DEFAULT));
+      if (user_key_len > 0) {
+        plain_options.user_key_len = user_key_len;
+      }
+      plain_options.bloom_bits_per_key = bloom_bits;
+      // without a prefix extractor PlainTable only has total order mode, which takes no hash
+      plain_options.hash_table_ratio = prefix_length > 0 ?
+                                       std::stod(props.GetProperty(PROP_PLAIN_HASH_RATIO,
+                                                                   PROP_PLAIN_HASH_RATIO_DEFAULT)) :
+                                       0;
+      plain_options.index_sparseness = std::stoul(props.GetProperty(PROP_PLAIN_INDEX_SPARSENESS,
+                                                                    PROP_PLAIN_INDEX_SPARSENESS_DEFAULT));
+      opt->table_factory.reset(rocksdb::NewPlainTableFactory(plain_options));
+    } else if (table_format == "block") {
+      size_t cache_size = std::stoul(props.GetProperty(PROP_CACHE_SIZE, PROP_CACHE_SIZE_DEFAULT));
+      // blocks evicted from the block cache stay compressed in the secondary cache, so a
+      // miss there costs a decompression instead of a read
+      std::shared_ptr<rocksdb::SecondaryCache> secondary_cache;
+      size_t compressed_cache_size = std::stoul(props.GetProperty(PROP_COMPRESSED_CACHE_SIZE,
+                                                                  PROP_COMPRESSED_CACHE_SIZE_DEFAULT));
+      if (compressed_cache_size > 0) {
+        rocksdb::CompressedSecondaryCacheOptions secondary_options;
+        secondary_options.capacity = compressed_cache_size * 1024 * 1024;
+        secondary_options.compression_type = CompressionFromString(
+            props.GetProperty(PROP_COMPRESSED_CACHE_COMPRESSION,
+                              PROP_COMPRESSED_CACHE_COMPRESSION_DEFAULT));
+        secondary_cache = rocksdb::NewCompressedSecondaryCache(secondary_options);
+      }
+      const std::string cache_type = props.GetProperty(PROP_CACHE_TYPE, PROP_CACHE_TYPE_DEFAULT);
+      if (cache_type == "lru") {
+        rocksdb::LRUCacheOptions cache_options;
+        cache_options.capacity = cache_size * 1024 *1024;
+        cache_options.secondary_cache = secondary_cache;
+        block_cache = rocksdb::NewLRUCache(cache_options);
+      } else if (cache_type == "hyperclock") {
+        // lock-free lookups; an entry charge of 0 lets the table size itself
+        rocksdb::HyperClockCacheOptions cache_options(
+            cache_size * 1024 * 1024,
+            std::stoul(props.GetProperty(PROP_HYPERCLOCK_ENTRY_CHARGE,
+                                         PROP_HYPERCLOCK_ENTRY_CHARGE_DEFAULT)));
+        cache_options.secondary_cache = secondary_cache;
+        block_cache = cache_options.MakeSharedCache();
+      } else {
+        throw utils::Exception("Unknown cache type: " + cache_type);
+      }
+      rocksdb::BlockBasedTableOptions table_options;
+      const size_t block_size = std::stoul(props.GetProperty(PROP_BLOCK_SIZE, PROP_BLOCK_SIZE_DEFAULT));
+      if (block_size > 0) {
+        table_options.block_size = block_size;
+      }
+      // table_options.checksum = rocksdb::kNoChecksum;
+      table_options.block_cache = block_cache;
+      table_options.cache_index_and_filter_blocks = props.GetProperty(
+          PROP_CACHE_INDEX_AND_FILTER, PROP_CACHE_INDEX_AND_FILTER_DEFAULT) == "true";
+      table_options.pin_l0_filter_and_index_blocks_in_cache = props.GetProperty(
+          PROP_PIN_L0_INDEX_AND_FILTER, PROP_PIN_L0_INDEX_AND_FILTER_DEFAULT) == "true";
+      table_options.index_type = IndexTypeFromString(props.GetProperty(PROP_INDEX_TYPE,
+                                                                       PROP_INDEX_TYPE_DEFAULT));
+      if (table_options.index_type == rocksdb::BlockBasedTableOptions::kHashSearch &&
+          prefix_length == 0) {
+        throw utils::Exception("RocksDB hash index needs rocksdb.prefix_length");
+      }
+      if (props.GetProperty(PROP_PARTITION_FILTERS, PROP_PARTITION_FILTERS_DEFAULT) == "true") {
+        if (table_options.index_type != rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch) {
+          throw utils::Exception("RocksDB partitioned filters need rocksdb.index_type=partitioned");
+        }
+        table_options.partition_filters = true;
+      }
+      // a hash table per data block turns the in-block binary search into one probe
+      table_options.data_block_index_type = DataBlockIndexTypeFromString(
+          props.GetProperty(PROP_DATA_BLOCK_INDEX_TYPE, PROP_DATA_BLOCK_INDEX_TYPE_DEFAULT));
+      table_options.data_block_hash_table_util_ratio = std::stod(
+          props.GetProperty(PROP_DATA_BLOCK_HASH_RATIO, PROP_DATA_BLOCK_HASH_RATIO_DEFAULT));
+      if (bloom_bits > 0) {
+        const std::string filter = props.GetProperty(PROP_FILTER_POLICY, PROP_FILTER_POLICY_DEFAULT);
+        if (filter == "bloom") {
+          table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bloom_bits));
+        } else if (filter == "ribbon") {
+          // same false positive rate as bloom_bits of bloom in about 30% less space, built
+          // with more CPU; levels below bloom_before_level keep the cheaper bloom filter
+          int bloom_before_level = std::stoi(props.GetProperty(PROP_RIBBON_BLOOM_BEFORE_LEVEL,
+                                                               PROP_RIBBON_BLOOM_BEFORE_LEVEL_DEFAULT));
+          table_options.filter_policy.reset(rocksdb::NewRibbonFilterPolicy(bloom_bits,
+                                                                           bloom_before_level));
+        } else {
+          throw utils::Exception("Unknown filter policy: " + filter);
+        }
+      }
+      opt->table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    } else {
+      throw utils::Exception("Unknown table format: " + table_format);
     }
-    opt->table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
 
     if (props.GetProperty(PROP_INCREASE_PARALLELISM, PROP_INCREASE_PARALLELISM_DEFAULT) == "true") {
       opt->IncreaseParallelism();
@@ -354,120 +1149,497 @@ void RocksdbDB::GetOptions(const utils::Properties &props, rocksdb::Options *opt
     if (props.GetProperty(PROP_OPTIMIZE_LEVELCOMP, PROP_OPTIMIZE_LEVELCOMP_DEFAULT) == "true") {
       opt->OptimizeLevelStyleCompaction();
     }
-  //}
+  }
+
+  // caps flush and compaction I/O; auto-tuned, the rate moves between a twentieth of the
+  // limit and the limit with the backlog of pending requests
+  const int64_t rate_limit = std::stoll(props.GetProperty(PROP_RATE_LIMIT, PROP_RATE_LIMIT_DEFAULT));
+  if (rate_limit > 0) {
+    rate_limiter.reset(rocksdb::NewGenericRateLimiter(
+        rate_limit,
+        std::stoll(props.GetProperty(PROP_RATE_LIMIT_REFILL_US, PROP_RATE_LIMIT_REFILL_US_DEFAULT)),
+        std::stoi(props.GetProperty(PROP_RATE_LIMIT_FAIRNESS, PROP_RATE_LIMIT_FAIRNESS_DEFAULT)),
+        RateLimiterModeFromString(props.GetProperty(PROP_RATE_LIMIT_MODE,
+                                                    PROP_RATE_LIMIT_MODE_DEFAULT)),
+        props.GetProperty(PROP_RATE_LIMIT_AUTO_TUNE, PROP_RATE_LIMIT_AUTO_TUNE_DEFAULT) == "true"));
+    opt->rate_limiter = rate_limiter;
+  }
+
+  SetBoolOption(props, PROP_PIPELINED_WRITE, PROP_PIPELINED_WRITE_DEFAULT,
+                &opt->enable_pipelined_write);
+  SetBoolOption(props, PROP_UNORDERED_WRITE, PROP_UNORDERED_WRITE_DEFAULT, &opt->unordered_write);
+  SetBoolOption(props, PROP_CONCURRENT_MEMTABLE_WRITE, PROP_CONCURRENT_MEMTABLE_WRITE_DEFAULT,
+                &opt->allow_concurrent_memtable_write);
+  SetBoolOption(props, PROP_TWO_WRITE_QUEUES, PROP_TWO_WRITE_QUEUES_DEFAULT, &opt->two_write_queues);
+
+  if (props.GetProperty(PROP_PERF_LEVEL, PROP_PERF_LEVEL_DEFAULT) != "disable") {
+    statistics = rocksdb::CreateDBStatistics();
+    opt->statistics = statistics;
+  } else if (props.GetProperty(PROP_CACHE_STATS, PROP_CACHE_STATS_DEFAULT) == "true") {
+    // the cache hit counters of the status line, without timing anything
+    statistics = rocksdb::CreateDBStatistics();
+    statistics->set_stats_level(rocksdb::kExceptHistogramOrTimers);
+    opt->statistics = statistics;
+  }
 }
 
-void RocksdbDB::SerializeRow(const std::vector<Field> &values, std::string &data) {
-  for (const Field &field : values) {
-    uint32_t len = field.name.size();
-    data.append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-    data.append(field.name.data(), field.name.size());
-    len = field.value.size();
-    data.append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-    data.append(field.value.data(), field.value.size());
+///
+/// Returns the column family of table, found by its table number so no lookup key is
+/// built; tables without one of their own use the default column family.
+///
+rocksdb::ColumnFamilyHandle *RocksdbDB::GetColumnFamily(std::string_view table) {
+  int n = CoreWorkload::TableNumber(table_names_, table);
+  return n >= 0 && table_cf_[n] != nullptr ? table_cf_[n] : db_->DefaultColumnFamily();
+}
+
+///
+/// Returns the instance's iterator over cf, refreshed to the latest data instead of
+/// allocated and set up anew for every scan. Stays valid until the next call for cf.
+///
+rocksdb::Iterator *RocksdbDB::GetIterator(IteratorCache &cache, const rocksdb::ReadOptions &options,
+                                          rocksdb::ColumnFamilyHandle *cf) {
+  std::unique_ptr<rocksdb::Iterator> &iter = cache[cf];
+  if (iter != nullptr && cache_iterators_) {
+    rocksdb::Status s = iter->Refresh();
+    if (s.ok()) {
+      return iter.get();
+    }
+    // iterators that do not support Refresh are recreated below
   }
+  iter.reset();
+  iter.reset(db_->NewIterator(options, cf));
+  return iter.get();
 }
 
-void RocksdbDB::DeserializeRowFilter(std::vector<Field> &values, const char *p, const char *lim,
-                                     const std::vector<std::string> &fields) {
-  std::vector<std::string>::const_iterator filter_iter = fields.begin();
-  while (p != lim && filter_iter != fields.end()) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    if (*filter_iter == field) {
-      values.push_back({field, value});
-      filter_iter++;
+std::vector<uint64_t> RocksdbDB::PerfSnapshot() {
+  std::vector<uint64_t> totals(kPerfOps * kPerfRow);
+  const std::lock_guard<std::mutex> lock(mu_);
+  for (const std::shared_ptr<PerfStats> &stats : perf_stats_) {
+    for (size_t op = 0; op < kPerfOps; op++) {
+      for (size_t i = 0; i < kPerfRow; i++) {
+        totals[op * kPerfRow + i] += stats->counts[op][i].load(std::memory_order_relaxed);
+      }
     }
   }
-  assert(values.size() == fields.size());
+  return totals;
 }
 
-void RocksdbDB::DeserializeRowFilter(std::vector<Field> &values, const std::string &data,
-                                     const std::vector<std::string> &fields) {
-  const char *p = data.data();
-  const char *lim = p + data.size();
-  DeserializeRowFilter(values, p, lim, fields);
+std::string RocksdbDB::StatusMsg() {
+  std::shared_ptr<rocksdb::Statistics> stats;
+  std::shared_ptr<rocksdb::Cache> cache;
+  bool perf;
+  {
+    // instances register from Init, which may still be running on the client threads
+    const std::lock_guard<std::mutex> lock(mu_);
+    perf = !perf_stats_.empty();
+    stats = statistics;
+    cache = block_cache;
+  }
+  std::ostringstream msg;
+  msg << std::fixed << std::setprecision(2);
+  if (perf) {
+    std::vector<uint64_t> totals = PerfSnapshot();
+    FormatPerf(msg, totals, perf_status_base, true);
+    perf_status_base.swap(totals);
+  }
+
+  if (stats != nullptr || cache != nullptr) {
+    msg << " [rocksdb:";
+  }
+  if (stats != nullptr) {
+    // hits in the secondary cache count as block cache hits too, the misses are of both
+    uint64_t hits = stats->getTickerCount(rocksdb::BLOCK_CACHE_HIT);
+    uint64_t misses = stats->getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+    uint64_t secondary_hits = stats->getTickerCount(rocksdb::SECONDARY_CACHE_HITS);
+    uint64_t stall = stats->getTickerCount(rocksdb::STALL_MICROS);
+    uint64_t lookups = hits - cache_hit_base + misses - cache_miss_base;
+    msg << " block_cache_hit_ratio="
+        << (lookups == 0 ? 0.0 : static_cast<double>(hits - cache_hit_base) / lookups);
+    if (secondary_hits != 0) {
+      uint64_t secondary_lookups = secondary_hits - secondary_hit_base + misses - cache_miss_base;
+      msg << " secondary_cache_hit_ratio="
+          << (secondary_lookups == 0 ? 0.0 :
+              static_cast<double>(secondary_hits - secondary_hit_base) / secondary_lookups);
+    }
+    msg << " stall_micros=" << stall - stall_micros_base;
+    cache_hit_base = hits;
+    cache_miss_base = misses;
+    secondary_hit_base = secondary_hits;
+    stall_micros_base = stall;
+  }
+  if (cache != nullptr) {
+    constexpr double kMiB = 1024 * 1024;
+    msg << " block_cache_usage=" << cache->GetUsage() / kMiB << "MiB"
+        << " pinned=" << cache->GetPinnedUsage() / kMiB << "MiB"
+        << " capacity=" << cache->GetCapacity() / kMiB << "MiB";
+  }
+  if (stats != nullptr || cache != nullptr) {
+    msg << "]";
+  }
+  return msg.str();
 }
 
-void RocksdbDB::DeserializeRow(std::vector<Field> &values, const char *p, const char *lim) {
-  while (p != lim) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    values.push_back({field, value});
+void RocksdbDB::PhaseReport(std::ostream &out, const std::string &phase) {
+  out << std::boolalpha << phase << " rocksdb write mode: disableWAL=" << write_options_.disableWAL
+      << " sync=" << write_options_.sync << " no_slowdown=" << write_options_.no_slowdown
+      << " low_pri=" << write_options_.low_pri << " " << db_write_mode << std::noboolalpha
+      << std::endl;
+
+  std::shared_ptr<rocksdb::Statistics> stats;
+  std::shared_ptr<rocksdb::RateLimiter> limiter;
+  bool perf;
+  {
+    const std::lock_guard<std::mutex> lock(mu_);
+    perf = !perf_stats_.empty();
+    stats = statistics;
+    limiter = rate_limiter;
+  }
+  if (stats != nullptr || limiter != nullptr) {
+    // stall time adds up over the writers held back, so it can exceed the phase time
+    out << phase << " rocksdb write throttling over " << (NowNs() - phase_start_ns) / 1e9 << " s:";
+    if (stats != nullptr) {
+      out << " write_stall_micros=" << PhaseTickerCount(*stats, rocksdb::STALL_MICROS);
+    }
+    if (limiter != nullptr) {
+      out << " rate_limited_bytes=" << limiter->GetTotalBytesThrough() - phase_limited_bytes_base
+          << " rate_limited_requests=" << limiter->GetTotalRequests() - phase_limited_requests_base;
+      if (stats != nullptr) {
+        // requests that drained the available bytes and waited for a refill
+        out << " rate_limiter_drains="
+            << PhaseTickerCount(*stats, rocksdb::NUMBER_RATE_LIMITER_DRAINS);
+      }
+      out << " rate_limit_bytes_per_sec=" << limiter->GetBytesPerSecond();
+    }
+    out << std::endl;
   }
+
+  if (blob_files_enabled) {
+    // the files of every table, and the blob traffic and write amplification of the phase;
+    // flush and compaction bytes include the blob files they wrote
+    BlobFileStats files;
+    {
+      // the client threads have finished, the last one may have closed the DB
+      const std::lock_guard<std::mutex> lock(mu_);
+      files = db_ != nullptr ? ReadBlobFileStats(db_, cf_handles_) : closed_blob_stats;
+    }
+    out << phase << " rocksdb blob files: count=" << files.files
+        << " total_bytes=" << files.total_size << " live_bytes=" << files.live_size
+        << " garbage_bytes=" << files.garbage_size;
+    if (stats != nullptr) {
+      uint64_t user_bytes = PhaseTickerCount(*stats, rocksdb::BYTES_WRITTEN);
+      uint64_t db_bytes = PhaseTickerCount(*stats, rocksdb::FLUSH_WRITE_BYTES) +
+                          PhaseTickerCount(*stats, rocksdb::COMPACT_WRITE_BYTES);
+      out << " blob_bytes_written="
+          << PhaseTickerCount(*stats, rocksdb::BLOB_DB_BLOB_FILE_BYTES_WRITTEN)
+          << " blob_bytes_read=" << PhaseTickerCount(*stats, rocksdb::BLOB_DB_BLOB_FILE_BYTES_READ)
+          << " gc_relocated_keys=" << PhaseTickerCount(*stats, rocksdb::BLOB_DB_GC_NUM_KEYS_RELOCATED)
+          << " gc_relocated_bytes=" << PhaseTickerCount(*stats, rocksdb::BLOB_DB_GC_BYTES_RELOCATED)
+          << " write_amp="
+          << (user_bytes == 0 ? 0.0 : static_cast<double>(db_bytes) / user_bytes);
+    }
+    out << std::endl;
+  }
+
+  if (merge_update_) {
+    out << phase << " rocksdb reads by merge operands applied:";
+    for (size_t i = 0; i < kMergeBuckets; i++) {
+      uint64_t count = merge_read_count[i].exchange(0);
+      uint64_t ns = merge_read_ns[i].exchange(0);
+      uint64_t max_ns = merge_read_max_ns[i].exchange(0);
+      if (count != 0) {
+        out << " [" << kMergeBucketString[i] << ": Count=" << count
+            << " Avg=" << ns / count / 1000.0 << " Max=" << max_ns / 1000.0 << "]";
+      }
+    }
+    out << " (us)" << std::endl;
+  }
+
+  if (!perf) {
+    return;
+  }
+  std::vector<uint64_t> totals = PerfSnapshot();
+  std::ostringstream report;
+  report << std::fixed << std::setprecision(2);
+  report << phase << " rocksdb perf context (per op; times in ns, sizes in bytes):\n";
+  FormatPerf(report, totals, perf_phase_base, false);
+  perf_phase_base = totals;
+  perf_status_base = totals;
+
+  if (stats != nullptr) {
+    report << phase << " rocksdb statistics:\n";
+    for (const auto &ticker : rocksdb::TickersNameMap) {
+      uint64_t count = stats->getTickerCount(ticker.first);
+      if (count != 0) {
+        report << "  " << std::left << std::setw(48) << ticker.second << std::right
+               << std::setw(16) << count << "\n";
+      }
+    }
+    // stalls, then the engine-side latency of the calls (micros)
+    const rocksdb::Histograms histograms[] = {
+      rocksdb::WRITE_STALL, rocksdb::DB_GET, rocksdb::DB_WRITE, rocksdb::DB_SEEK,
+      rocksdb::DB_MULTIGET, rocksdb::SST_READ_MICROS,
+    };
+    for (const auto &name : rocksdb::HistogramsNameMap) {
+      if (std::find(std::begin(histograms), std::end(histograms), name.first) ==
+          std::end(histograms)) {
+        continue;
+      }
+      rocksdb::HistogramData data;
+      stats->histogramData(name.first, &data);
+      if (data.count == 0) {
+        continue;
+      }
+      report << "  " << name.second << ": Count=" << data.count << " Avg=" << data.average
+             << " 50th=" << data.median << " 99th=" << data.percentile99
+             << " Max=" << data.max << "\n";
+    }
+    stats->Reset();
+    cache_hit_base = cache_miss_base = secondary_hit_base = stall_micros_base = 0;
+  }
+  out << report.str();
 }
 
-void RocksdbDB::DeserializeRow(std::vector<Field> &values, const std::string &data) {
-  const char *p = data.data();
-  const char *lim = p + data.size();
-  DeserializeRow(values, p, lim);
+DB::Status RocksdbDB::ReadView(std::string_view table, std::string_view key,
+                               const std::vector<std::string> *fields,
+                               std::vector<FieldView> &result) {
+  if (format_ != kSingleRow) {
+    return DB::ReadView(table, key, fields, result);
+  }
+  PerfScope perf(perf_.get(), READ);
+  // the views point straight into the pinned block cache entry or memtable value
+  pinned_.Reset();
+  rocksdb::Status s = Get(GetColumnFamily(table),
+                          rocksdb::Slice(key.data(), key.size()), &pinned_);
+  if (s.IsNotFound()) {
+    return kNotFound;
+  } else if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB Get: ") + s.ToString());
+  }
+  result.clear();
+  std::string_view data(pinned_.data(), pinned_.size());
+  if (fields != nullptr) {
+    codec_.DecodeFilter(data, *fields, &result);
+  } else {
+    codec_.Decode(data, &result);
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::ScanView(std::string_view table, std::string_view key, int len,
+                               const std::vector<std::string> *fields,
+                               std::vector<std::vector<FieldView>> &result) {
+  if (format_ != kSingleRow) {
+    return DB::ScanView(table, key, len, fields, result);
+  }
+  PerfScope perf(perf_.get(), SCAN);
+  // iterator values move as it advances unless pinned, so unpinned ones are copied
+  // once into the arena; pinned ones stay valid until the iterator seeks again
+  arena_.Reset();
+  result.clear();
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_,
+                                           GetColumnFamily(table));
+  db_iter->Seek(rocksdb::Slice(key.data(), key.size()));
+  for (int i = 0; db_iter->Valid() && i < len; i++) {
+    rocksdb::Slice value = db_iter->value();
+    std::string_view data = db_iter->IsValuePinned() ?
+                            std::string_view(value.data(), value.size()) :
+                            arena_.Copy(value.data(), value.size());
+    result.push_back(std::vector<FieldView>());
+    if (fields != nullptr) {
+      codec_.DecodeFilter(data, *fields, &result.back());
+    } else {
+      codec_.Decode(data, &result.back());
+    }
+    db_iter->Next();
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::ScanVisit(std::string_view table, std::string_view key, int len,
+                                const std::vector<std::string> *fields,
+                                const ScanVisitor &visitor) {
+  if (format_ != kSingleRow) {
+    return DB::ScanVisit(table, key, len, fields, visitor);
+  }
+  PerfScope perf(perf_.get(), SCAN);
+  // the views point into the iterator's current value, valid until Next()
+  std::vector<FieldView> record;
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_,
+                                           GetColumnFamily(table));
+  db_iter->Seek(rocksdb::Slice(key.data(), key.size()));
+  for (int i = 0; db_iter->Valid() && i < len; i++) {
+    std::string_view data(db_iter->value().data(), db_iter->value().size());
+    record.clear();
+    if (fields != nullptr) {
+      codec_.DecodeFilter(data, *fields, &record);
+    } else {
+      codec_.Decode(data, &record);
+    }
+    if (!visitor(record)) {
+      break;
+    }
+    db_iter->Next();
+  }
+  rocksdb::Status s = db_iter->status();
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB Scan: ") + s.ToString());
+  }
+  return kOK;
+}
+
+// With merge updates, also times the Get by the merge operands it had to apply.
+rocksdb::Status RocksdbDB::Get(rocksdb::ColumnFamilyHandle *cf, const rocksdb::Slice &key,
+                               rocksdb::PinnableSlice *value) {
+  if (!merge_update_) {
+    return db_->Get(rocksdb::ReadOptions(), cf, key, value);
+  }
+  TakeMergeOperandCount();
+  const uint64_t start = NowNs();
+  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), cf, key, value);
+  RecordMergeRead(TakeMergeOperandCount(), NowNs() - start);
+  return s;
 }
 
 DB::Status RocksdbDB::ReadSingle(const std::string &table, const std::string &key,
                                  const std::vector<std::string> *fields,
                                  std::vector<Field> &result) {
-  std::string data;
-  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), key, &data);
+  PerfScope perf(perf_.get(), READ);
+  // decoded straight from the block cache entry or memtable value it pins
+  rocksdb::PinnableSlice data;
+  rocksdb::Status s = Get(GetColumnFamily(table), key, &data);
   if (s.IsNotFound()) {
     return kNotFound;
   } else if (!s.ok()) {
     throw utils::Exception(std::string("RocksDB Get: ") + s.ToString());
   }
+  std::string_view view(data.data(), data.size());
   if (fields != nullptr) {
-    DeserializeRowFilter(result, data, *fields);
+    codec_.DecodeFilter(view, *fields, &result);
   } else {
-    DeserializeRow(result, data);
+    codec_.Decode(view, &result);
     assert(result.size() == static_cast<size_t>(fieldcount_));
   }
   return kOK;
 }
 
+void RocksdbDB::SubmitRead(const std::string &table, const std::string &key,
+                           const std::vector<std::string> *fields, std::vector<Field> *result,
+                           Completion done) {
+  if (format_ != kSingleRow) {
+    DB::SubmitRead(table, key, fields, result, std::move(done));
+    return;
+  }
+  pending_reads_.push_back({GetColumnFamily(table), &key, fields, result, std::move(done)});
+}
+
+// The reads submitted since the last Poll go out as one MultiGet. With async_io
+// RocksDB reads their blocks concurrently instead of one after the other.
+int RocksdbDB::Poll(int min_completions) {
+  if (pending_reads_.empty()) {
+    return DB::Poll(min_completions);
+  }
+  std::vector<PendingRead> reads;
+  reads.swap(pending_reads_);
+  const size_t n = reads.size();
+  std::vector<rocksdb::ColumnFamilyHandle *> cfs(n);
+  std::vector<rocksdb::Slice> keys(n);
+  std::vector<rocksdb::PinnableSlice> values(n);
+  std::vector<rocksdb::Status> statuses(n);
+  for (size_t i = 0; i < n; i++) {
+    cfs[i] = reads[i].cf;
+    keys[i] = *reads[i].key;
+  }
+  rocksdb::ReadOptions read_options;
+  read_options.async_io = async_io_;
+  PerfScope perf(perf_.get(), READ, n);
+  db_->MultiGet(read_options, n, cfs.data(), keys.data(), values.data(), statuses.data());
+
+  for (size_t i = 0; i < n; i++) {
+    if (statuses[i].IsNotFound()) {
+      reads[i].done(kNotFound);
+      continue;
+    } else if (!statuses[i].ok()) {
+      throw utils::Exception(std::string("RocksDB MultiGet: ") + statuses[i].ToString());
+    }
+    std::string_view data(values[i].data(), values[i].size());
+    if (reads[i].fields != nullptr) {
+      codec_.DecodeFilter(data, *reads[i].fields, reads[i].result);
+    } else {
+      codec_.Decode(data, reads[i].result);
+    }
+    reads[i].done(kOK);
+  }
+  // updates and inserts run on the shared pool and may have finished meanwhile
+  return n + DB::Poll(std::max(0, min_completions - static_cast<int>(n)));
+}
+
 DB::Status RocksdbDB::ScanSingle(const std::string &table, const std::string &key, int len,
                                  const std::vector<std::string> *fields,
                                  std::vector<std::vector<Field>> &result) {
-  rocksdb::Iterator *db_iter = db_->NewIterator(rocksdb::ReadOptions());
-  db_iter->Seek(key);
+  return ScanVisit(table, key, len, fields, [&result](const std::vector<FieldView> &record) {
+    AppendRecord(record, result);
+    return true;
+  });
+}
+
+DB::Status RocksdbDB::ReverseScanSingle(const std::string &table, const std::string &key,
+                                        int len, const std::vector<std::string> *fields,
+                                        std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), REVERSE_SCAN);
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_, GetColumnFamily(table));
+  db_iter->SeekForPrev(key);
   for (int i = 0; db_iter->Valid() && i < len; i++) {
-    std::string data = db_iter->value().ToString();
+    std::string_view data(db_iter->value().data(), db_iter->value().size());
     result.push_back(std::vector<Field>());
     std::vector<Field> &values = result.back();
     if (fields != nullptr) {
-      DeserializeRowFilter(values, data, *fields);
+      codec_.DecodeFilter(data, *fields, &values);
     } else {
-      DeserializeRow(values, data);
+      codec_.Decode(data, &values);
+      assert(values.size() == static_cast<size_t>(fieldcount_));
+    }
+    db_iter->Prev();
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::RangeScanSingle(const std::string &table, const std::string &start_key,
+                                      const std::string &end_key,
+                                      const std::vector<std::string> *fields,
+                                      std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), RANGE_SCAN);
+  // the upper bound lets RocksDB stop at the range end instead of the caller, skipping
+  // files and blocks past it
+  range_upper_bound_ = end_key;
+  rocksdb::Iterator *db_iter = GetIterator(range_iterators_, range_options_, GetColumnFamily(table));
+  for (db_iter->Seek(start_key); db_iter->Valid(); db_iter->Next()) {
+    std::string_view data(db_iter->value().data(), db_iter->value().size());
+    result.push_back(std::vector<Field>());
+    std::vector<Field> &values = result.back();
+    if (fields != nullptr) {
+      codec_.DecodeFilter(data, *fields, &values);
+    } else {
+      codec_.Decode(data, &values);
       assert(values.size() == static_cast<size_t>(fieldcount_));
     }
-    db_iter->Next();
   }
-  delete db_iter;
   return kOK;
 }
 
 DB::Status RocksdbDB::UpdateSingle(const std::string &table, const std::string &key,
                                    std::vector<Field> &values) {
-  std::string data;
-  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), key, &data);
+  PerfScope perf(perf_.get(), UPDATE);
+  rocksdb::ColumnFamilyHandle *cf = GetColumnFamily(table);
+  rocksdb::PinnableSlice current;
+  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), cf, key, &current);
   if (s.IsNotFound()) {
     return kNotFound;
   } else if (!s.ok()) {
     throw utils::Exception(std::string("RocksDB Get: ") + s.ToString());
   }
   std::vector<Field> current_values;
-  DeserializeRow(current_values, data);
+  codec_.Decode(std::string_view(current.data(), current.size()), &current_values);
+  current.Reset();
   assert(current_values.size() == static_cast<size_t>(fieldcount_));
   for (Field &new_field : values) {
     bool found MAYBE_UNUSED = false;
@@ -480,11 +1652,9 @@ DB::Status RocksdbDB::UpdateSingle(const std::string &table, const std::string &
     }
     assert(found);
   }
-  rocksdb::WriteOptions wopt;
-
-  data.clear();
-  SerializeRow(current_values, data);
-  s = db_->Put(wopt, key, data);
+  std::string data;
+  codec_.Encode(current_values, &data);
+  s = db_->Put(write_options_, cf, key, data);
   if (!s.ok()) {
     throw utils::Exception(std::string("RocksDB Put: ") + s.ToString());
   }
@@ -493,10 +1663,11 @@ DB::Status RocksdbDB::UpdateSingle(const std::string &table, const std::string &
 
 DB::Status RocksdbDB::MergeSingle(const std::string &table, const std::string &key,
                                   std::vector<Field> &values) {
+  PerfScope perf(perf_.get(), UPDATE);
+  // a blind write of the updated fields only; reads and compactions apply it
   std::string data;
-  SerializeRow(values, data);
-  rocksdb::WriteOptions wopt;
-  rocksdb::Status s = db_->Merge(wopt, key, data);
+  EncodeMergeOperand(values, &data);
+  rocksdb::Status s = db_->Merge(write_options_, GetColumnFamily(table), key, data);
   if (!s.ok()) {
     throw utils::Exception(std::string("RocksDB Merge: ") + s.ToString());
   }
@@ -505,29 +1676,530 @@ DB::Status RocksdbDB::MergeSingle(const std::string &table, const std::string &k
 
 DB::Status RocksdbDB::InsertSingle(const std::string &table, const std::string &key,
                                    std::vector<Field> &values) {
+  PerfScope perf(perf_.get(), INSERT);
   std::string data;
-  SerializeRow(values, data);
-  rocksdb::WriteOptions wopt;
-  rocksdb::Status s = db_->Put(wopt, key, data);
+  codec_.Encode(values, &data);
+  rocksdb::Status s = db_->Put(write_options_, GetColumnFamily(table), key, data);
   if (!s.ok()) {
     throw utils::Exception(std::string("RocksDB Put: ") + s.ToString());
   }
   return kOK;
 }
 
+// Writes the stream into SST files of target_file_size_base each, then ingests
+// them at once, the way a production import builds a database.
+DB::Status RocksdbDB::BulkLoad(const std::string &table, RecordStream &records) {
+  // composite keys do not follow the stream's order: column-major ones start with the
+  // field name, and row-major "user123:field0" sorts after "user1234:field0"; SstFileWriter
+  // keeps values inline, so with blob files only flushes separate them
+  if (format_ == kRowMajor || format_ == kColumnMajor || blob_files_enabled) {
+    return DB::BulkLoad(table, records);
+  }
+
+  rocksdb::ColumnFamilyHandle *cf = GetColumnFamily(table);
+  const rocksdb::Options options = db_->GetOptions(cf);
+  rocksdb::Env *env = options.env;
+  const std::string dir = db_->GetName() + "/bulkload";
+  rocksdb::Status s = env->CreateDirIfMissing(dir);
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB BulkLoad CreateDir: ") + s.ToString());
+  }
+
+  rocksdb::SstFileWriter writer(rocksdb::EnvOptions(options), options, cf);
+  std::vector<std::string> files;
+  bool open = false;
+  std::string key, data;
+  std::vector<Field> values;
+  while (records.Next(&key, &values)) {
+    if (!open) {
+      files.push_back(dir + "/" + table + "-" + std::to_string(files.size()) + ".sst");
+      s = writer.Open(files.back());
+      if (!s.ok()) {
+        throw utils::Exception(std::string("RocksDB SstFileWriter Open: ") + s.ToString());
+      }
+      open = true;
+    }
+    if (format_ == kWideColumn) {
+      s = writer.PutEntity(key, ToColumns(values));
+    } else {
+      data.clear();
+      codec_.Encode(values, &data);
+      s = writer.Put(key, data);
+    }
+    if (!s.ok()) {
+      throw utils::Exception(std::string("RocksDB SstFileWriter Put: ") + s.ToString());
+    }
+    if (writer.FileSize() >= options.target_file_size_base) {
+      s = writer.Finish();
+      if (!s.ok()) {
+        throw utils::Exception(std::string("RocksDB SstFileWriter Finish: ") + s.ToString());
+      }
+      open = false;
+    }
+  }
+  if (open) {
+    s = writer.Finish();
+    if (!s.ok()) {
+      throw utils::Exception(std::string("RocksDB SstFileWriter Finish: ") + s.ToString());
+    }
+  }
+
+  if (!files.empty()) {
+    rocksdb::IngestExternalFileOptions ingest_options;
+    ingest_options.move_files = true;
+    s = db_->IngestExternalFile(cf, files, ingest_options);
+    if (!s.ok()) {
+      throw utils::Exception(std::string("RocksDB IngestExternalFile: ") + s.ToString());
+    }
+  }
+  // a successful move ingestion removes the files it linked into the db; any left over,
+  // e.g. copied when linking failed, go here
+  for (const std::string &file : files) {
+    s = env->DeleteFile(file);
+    if (!s.ok() && !s.IsNotFound()) {
+      throw utils::Exception(std::string("RocksDB BulkLoad DeleteFile: ") + s.ToString());
+    }
+  }
+  s = env->DeleteDir(dir);
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB BulkLoad DeleteDir: ") + s.ToString());
+  }
+  return kOK;
+}
+
 DB::Status RocksdbDB::DeleteSingle(const std::string &table, const std::string &key) {
-  rocksdb::WriteOptions wopt;
-  rocksdb::Status s = db_->Delete(wopt, key);
+  PerfScope perf(perf_.get(), DELETE);
+  rocksdb::Status s = db_->Delete(write_options_, GetColumnFamily(table), key);
   if (!s.ok()) {
     throw utils::Exception(std::string("RocksDB Delete: ") + s.ToString());
   }
   return kOK;
 }
 
+std::string RocksdbDB::BuildCompKey(const std::string &key, const std::string &field_name) const {
+  switch (format_) {
+    case kRowMajor:
+      return key + ":" + field_name;
+    case kColumnMajor:
+      return field_name + ":" + key;
+    default:
+      throw utils::Exception("wrong format");
+  }
+}
+
+// Field names hold no ':', keys may, so the separator is the last ':' of a row-major
+// key and the first one of a column-major key.
+std::string RocksdbDB::KeyFromCompKey(const std::string &comp_key) const {
+  if (format_ == kRowMajor) {
+    return comp_key.substr(0, comp_key.rfind(':'));
+  }
+  return comp_key.substr(comp_key.find(':') + 1);
+}
+
+std::string RocksdbDB::FieldFromCompKey(const std::string &comp_key) const {
+  if (format_ == kRowMajor) {
+    return comp_key.substr(comp_key.rfind(':') + 1);
+  }
+  return comp_key.substr(0, comp_key.find(':'));
+}
+
+///
+/// Adds the row-major field under db_iter to the row it belongs to, starting a new
+/// row when its key changes from row_key. Returns false, adding nothing, once the
+/// field would start row len + 1.
+///
+bool RocksdbDB::AddCompKeyField(const rocksdb::Iterator *db_iter, size_t len,
+                                const std::vector<std::string> *fields, std::string &row_key,
+                                std::vector<std::vector<Field>> &result) const {
+  const std::string comp_key = db_iter->key().ToString();
+  std::string cur_key = KeyFromCompKey(comp_key);
+  if (result.empty() || cur_key != row_key) {
+    if (result.size() == len) {
+      return false;
+    }
+    row_key = std::move(cur_key);
+    result.push_back(std::vector<Field>());
+  }
+  std::string cur_field = FieldFromCompKey(comp_key);
+  if (fields == nullptr || std::find(fields->begin(), fields->end(), cur_field) != fields->end()) {
+    result.back().push_back({std::move(cur_field), db_iter->value().ToString()});
+  }
+  return true;
+}
+
+// Every field is a key of its own, so the requested ones are point reads in one batch
+// and a single-field read fetches nothing else.
+DB::Status RocksdbDB::MultiGetCompKeys(rocksdb::ColumnFamilyHandle *cf, const std::string &key,
+                                       const std::vector<std::string> &fields,
+                                       std::vector<Field> &result) {
+  const size_t n = fields.size();
+  std::vector<std::string> comp_keys(n);
+  std::vector<rocksdb::Slice> keys(n);
+  for (size_t i = 0; i < n; i++) {
+    comp_keys[i] = BuildCompKey(key, fields[i]);
+    keys[i] = comp_keys[i];
+  }
+  std::vector<rocksdb::PinnableSlice> values(n);
+  std::vector<rocksdb::Status> statuses(n);
+  db_->MultiGet(rocksdb::ReadOptions(), cf, n, keys.data(), values.data(), statuses.data());
+  for (size_t i = 0; i < n; i++) {
+    if (statuses[i].IsNotFound()) {
+      continue;
+    } else if (!statuses[i].ok()) {
+      throw utils::Exception(std::string("RocksDB MultiGet: ") + statuses[i].ToString());
+    }
+    result.push_back({fields[i], values[i].ToString()});
+  }
+  return result.empty() ? kNotFound : kOK;
+}
+
+DB::Status RocksdbDB::ReadCompKeyRM(const std::string &table, const std::string &key,
+                                    const std::vector<std::string> *fields,
+                                    std::vector<Field> &result) {
+  PerfScope perf(perf_.get(), READ);
+  rocksdb::ColumnFamilyHandle *cf = GetColumnFamily(table);
+  if (fields != nullptr) {
+    return MultiGetCompKeys(cf, key, *fields, result);
+  }
+  // ';' sorts right after ':', so the fields of key are exactly the keys below key + ";"
+  const std::string prefix = key + ":";
+  const std::string limit = key + ";";
+  range_upper_bound_ = limit;
+  rocksdb::Iterator *db_iter = GetIterator(range_iterators_, range_options_, cf);
+  for (db_iter->Seek(prefix); db_iter->Valid(); db_iter->Next()) {
+    result.push_back({FieldFromCompKey(db_iter->key().ToString()), db_iter->value().ToString()});
+  }
+  rocksdb::Status s = db_iter->status();
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB Read: ") + s.ToString());
+  }
+  return result.empty() ? kNotFound : kOK;
+}
+
+DB::Status RocksdbDB::ScanCompKeyRM(const std::string &table, const std::string &key, int len,
+                                    const std::vector<std::string> *fields,
+                                    std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), SCAN);
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_, GetColumnFamily(table));
+  std::string row_key;
+  for (db_iter->Seek(key); db_iter->Valid(); db_iter->Next()) {
+    if (!AddCompKeyField(db_iter, len, fields, row_key, result)) {
+      break;
+    }
+  }
+  rocksdb::Status s = db_iter->status();
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB Scan: ") + s.ToString());
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::ReverseScanCompKeyRM(const std::string &table, const std::string &key,
+                                           int len, const std::vector<std::string> *fields,
+                                           std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), REVERSE_SCAN);
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_, GetColumnFamily(table));
+  // lands on the last field of key; fields then come in descending order, so each row
+  // is flipped afterwards
+  std::string row_key;
+  for (db_iter->SeekForPrev(key + ";"); db_iter->Valid(); db_iter->Prev()) {
+    if (!AddCompKeyField(db_iter, len, fields, row_key, result)) {
+      break;
+    }
+  }
+  rocksdb::Status s = db_iter->status();
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB ReverseScan: ") + s.ToString());
+  }
+  for (std::vector<Field> &values : result) {
+    std::reverse(values.begin(), values.end());
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::RangeScanCompKeyRM(const std::string &table, const std::string &start_key,
+                                         const std::string &end_key,
+                                         const std::vector<std::string> *fields,
+                                         std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), RANGE_SCAN);
+  // no upper bound: with keys of different lengths a row below end_key may still have
+  // composite keys above it
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_, GetColumnFamily(table));
+  std::string row_key;
+  for (db_iter->Seek(start_key); db_iter->Valid(); db_iter->Next()) {
+    if (KeyFromCompKey(db_iter->key().ToString()) >= end_key) {
+      break;
+    }
+    AddCompKeyField(db_iter, SIZE_MAX, fields, row_key, result);
+  }
+  rocksdb::Status s = db_iter->status();
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB RangeScan: ") + s.ToString());
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::ReadCompKeyCM(const std::string &table, const std::string &key,
+                                    const std::vector<std::string> *fields,
+                                    std::vector<Field> &result) {
+  PerfScope perf(perf_.get(), READ);
+  return MultiGetCompKeys(GetColumnFamily(table), key, fields != nullptr ? *fields : field_names_,
+                          result);
+}
+
+///
+/// Column-major scan: every field is a run of keys of its own, walked field after field
+/// with one iterator so all runs see the same data. The first run picks the rows, from
+/// key on in the scan direction, up to len of them or up to end_key if given. The
+/// others supply the same rows, since a row's fields are written and deleted together.
+///
+DB::Status RocksdbDB::ScanColumns(const std::string &table, const std::string &key, size_t len,
+                                  const std::string *end_key, bool reverse,
+                                  const std::vector<std::string> *fields,
+                                  std::vector<std::vector<Field>> &result) {
+  const std::vector<std::string> &names = fields != nullptr ? *fields : field_names_;
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_, GetColumnFamily(table));
+  const size_t first_row = result.size();
+  size_t rows = 0;
+  for (size_t j = 0; j < names.size(); j++) {
+    const std::string prefix = names[j] + ":";
+    if (reverse) {
+      db_iter->SeekForPrev(prefix + key);
+    } else {
+      db_iter->Seek(prefix + key);
+    }
+    for (size_t i = 0; db_iter->Valid() && db_iter->key().starts_with(prefix); i++) {
+      if (j == 0) {
+        if (i == len || (end_key != nullptr &&
+                         KeyFromCompKey(db_iter->key().ToString()) >= *end_key)) {
+          break;
+        }
+        result.push_back(std::vector<Field>());
+        rows++;
+      } else if (i == rows) {
+        break;
+      }
+      result[first_row + i].push_back({names[j], db_iter->value().ToString()});
+      if (reverse) {
+        db_iter->Prev();
+      } else {
+        db_iter->Next();
+      }
+    }
+    rocksdb::Status s = db_iter->status();
+    if (!s.ok()) {
+      throw utils::Exception(std::string("RocksDB Scan: ") + s.ToString());
+    }
+    if (rows == 0) {
+      break;
+    }
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::ScanCompKeyCM(const std::string &table, const std::string &key, int len,
+                                    const std::vector<std::string> *fields,
+                                    std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), SCAN);
+  return ScanColumns(table, key, len, nullptr, false, fields, result);
+}
+
+DB::Status RocksdbDB::ReverseScanCompKeyCM(const std::string &table, const std::string &key,
+                                           int len, const std::vector<std::string> *fields,
+                                           std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), REVERSE_SCAN);
+  return ScanColumns(table, key, len, nullptr, true, fields, result);
+}
+
+DB::Status RocksdbDB::RangeScanCompKeyCM(const std::string &table, const std::string &start_key,
+                                         const std::string &end_key,
+                                         const std::vector<std::string> *fields,
+                                         std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), RANGE_SCAN);
+  return ScanColumns(table, start_key, SIZE_MAX, &end_key, false, fields, result);
+}
+
+// Inserts and updates alike: a blind write of the given fields, nothing is read.
+void RocksdbDB::WriteCompKeys(const std::string &table, const std::string &key,
+                              const std::vector<Field> &values) {
+  rocksdb::ColumnFamilyHandle *cf = GetColumnFamily(table);
+  rocksdb::WriteBatch batch;
+  for (const Field &field : values) {
+    rocksdb::Status s = batch.Put(cf, BuildCompKey(key, field.name), field.value);
+    if (!s.ok()) {
+      throw utils::Exception(std::string("RocksDB WriteBatch Put: ") + s.ToString());
+    }
+  }
+  rocksdb::Status s = db_->Write(write_options_, &batch);
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB Write: ") + s.ToString());
+  }
+}
+
+DB::Status RocksdbDB::UpdateCompKey(const std::string &table, const std::string &key,
+                                    std::vector<Field> &values) {
+  PerfScope perf(perf_.get(), UPDATE);
+  WriteCompKeys(table, key, values);
+  return kOK;
+}
+
+DB::Status RocksdbDB::InsertCompKey(const std::string &table, const std::string &key,
+                                    std::vector<Field> &values) {
+  PerfScope perf(perf_.get(), INSERT);
+  WriteCompKeys(table, key, values);
+  return kOK;
+}
+
+DB::Status RocksdbDB::DeleteCompKey(const std::string &table, const std::string &key) {
+  PerfScope perf(perf_.get(), DELETE);
+  rocksdb::ColumnFamilyHandle *cf = GetColumnFamily(table);
+  rocksdb::WriteBatch batch;
+  for (const std::string &field : field_names_) {
+    rocksdb::Status s = batch.Delete(cf, BuildCompKey(key, field));
+    if (!s.ok()) {
+      throw utils::Exception(std::string("RocksDB WriteBatch Delete: ") + s.ToString());
+    }
+  }
+  rocksdb::Status s = db_->Write(write_options_, &batch);
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB Write: ") + s.ToString());
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::ReadWide(const std::string &table, const std::string &key,
+                               const std::vector<std::string> *fields,
+                               std::vector<Field> &result) {
+  PerfScope perf(perf_.get(), READ);
+  rocksdb::PinnableWideColumns columns;
+  rocksdb::Status s = db_->GetEntity(rocksdb::ReadOptions(), GetColumnFamily(table), key,
+                                     &columns);
+  if (s.IsNotFound()) {
+    return kNotFound;
+  } else if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB GetEntity: ") + s.ToString());
+  }
+  AppendColumns(columns.columns(), fields, result);
+  return kOK;
+}
+
+DB::Status RocksdbDB::ScanWide(const std::string &table, const std::string &key, int len,
+                               const std::vector<std::string> *fields,
+                               std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), SCAN);
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_, GetColumnFamily(table));
+  db_iter->Seek(key);
+  for (int i = 0; db_iter->Valid() && i < len; i++) {
+    result.push_back(std::vector<Field>());
+    AppendColumns(db_iter->columns(), fields, result.back());
+    db_iter->Next();
+  }
+  rocksdb::Status s = db_iter->status();
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB Scan: ") + s.ToString());
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::ReverseScanWide(const std::string &table, const std::string &key, int len,
+                                      const std::vector<std::string> *fields,
+                                      std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), REVERSE_SCAN);
+  rocksdb::Iterator *db_iter = GetIterator(scan_iterators_, scan_options_, GetColumnFamily(table));
+  db_iter->SeekForPrev(key);
+  for (int i = 0; db_iter->Valid() && i < len; i++) {
+    result.push_back(std::vector<Field>());
+    AppendColumns(db_iter->columns(), fields, result.back());
+    db_iter->Prev();
+  }
+  rocksdb::Status s = db_iter->status();
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB ReverseScan: ") + s.ToString());
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::RangeScanWide(const std::string &table, const std::string &start_key,
+                                    const std::string &end_key,
+                                    const std::vector<std::string> *fields,
+                                    std::vector<std::vector<Field>> &result) {
+  PerfScope perf(perf_.get(), RANGE_SCAN);
+  range_upper_bound_ = end_key;
+  rocksdb::Iterator *db_iter = GetIterator(range_iterators_, range_options_, GetColumnFamily(table));
+  for (db_iter->Seek(start_key); db_iter->Valid(); db_iter->Next()) {
+    result.push_back(std::vector<Field>());
+    AppendColumns(db_iter->columns(), fields, result.back());
+  }
+  rocksdb::Status s = db_iter->status();
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB RangeScan: ") + s.ToString());
+  }
+  return kOK;
+}
+
+// PutEntity replaces the whole entity, so an update of every field is a blind write,
+// while a partial one reads the current columns back, without decoding a row, and
+// writes them with the new values.
+DB::Status RocksdbDB::UpdateWide(const std::string &table, const std::string &key,
+                                 std::vector<Field> &values) {
+  PerfScope perf(perf_.get(), UPDATE);
+  rocksdb::ColumnFamilyHandle *cf = GetColumnFamily(table);
+  rocksdb::Status s;
+  if (values.size() == field_names_.size()) {
+    s = db_->PutEntity(write_options_, cf, key, ToColumns(values));
+  } else {
+    rocksdb::PinnableWideColumns current;
+    s = db_->GetEntity(rocksdb::ReadOptions(), cf, key, &current);
+    if (s.IsNotFound()) {
+      return kNotFound;
+    } else if (!s.ok()) {
+      throw utils::Exception(std::string("RocksDB GetEntity: ") + s.ToString());
+    }
+    // the slices point into current and values, both alive until the write is done
+    rocksdb::WideColumns columns = current.columns();
+    for (const Field &field : values) {
+      auto it = std::lower_bound(columns.begin(), columns.end(), field.name,
+                                 [](const rocksdb::WideColumn &column, const std::string &name) {
+                                   return column.name().compare(name) < 0;
+                                 });
+      if (it != columns.end() && it->name() == field.name) {
+        it->value() = field.value;
+      } else {
+        columns.emplace(it, field.name, field.value);
+      }
+    }
+    s = db_->PutEntity(write_options_, cf, key, columns);
+  }
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB PutEntity: ") + s.ToString());
+  }
+  return kOK;
+}
+
+DB::Status RocksdbDB::InsertWide(const std::string &table, const std::string &key,
+                                 std::vector<Field> &values) {
+  PerfScope perf(perf_.get(), INSERT);
+  rocksdb::Status s = db_->PutEntity(write_options_, GetColumnFamily(table), key,
+                                     ToColumns(values));
+  if (!s.ok()) {
+    throw utils::Exception(std::string("RocksDB PutEntity: ") + s.ToString());
+  }
+  return kOK;
+}
+
 DB *NewRocksdbDB() {
   return new RocksdbDB;
 }
 
 const bool registered = DBFactory::RegisterDB("rocksdb", NewRocksdbDB);
 
+static bool SingleRowFormat(const utils::Properties &props) {
+  if (props.GetProperty(PROP_MERGEUPDATE, PROP_MERGEUPDATE_DEFAULT) == "true") {
+    return false;
+  }
+  return props.GetProperty(PROP_FORMAT, PROP_FORMAT_DEFAULT) == "single";
+}
+
+const bool registered_static = RegisterStaticDB<RocksdbDB::SingleRow>("rocksdb", SingleRowFormat);
+
 } // ycsbc
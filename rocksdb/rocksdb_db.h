@@ -8,11 +8,15 @@
 #ifndef YCSB_C_ROCKSDB_DB_H_
 #define YCSB_C_ROCKSDB_DB_H_
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <unordered_map>
 
 #include "core/db.h"
 #include "core/properties.h"
+#include "core/row_codec.h"
 
 #include <rocksdb/db.h>
 #include <rocksdb/options.h>
@@ -28,6 +32,8 @@ class RocksdbDB : public DB {
 
   void Cleanup();
 
+  class SingleRow;
+
   Status Read(const std::string &table, const std::string &key,
               const std::vector<std::string> *fields, std::vector<Field> &result) {
     return (this->*(method_read_))(table, key, fields, result);
@@ -38,6 +44,28 @@ class RocksdbDB : public DB {
     return (this->*(method_scan_))(table, key, len, fields, result);
   }
 
+  Status ReadView(std::string_view table, std::string_view key,
+                  const std::vector<std::string> *fields, std::vector<FieldView> &result);
+
+  Status ScanView(std::string_view table, std::string_view key, int len,
+                  const std::vector<std::string> *fields,
+                  std::vector<std::vector<FieldView>> &result);
+
+  Status ScanVisit(std::string_view table, std::string_view key, int len,
+                   const std::vector<std::string> *fields, const ScanVisitor &visitor);
+
+  Status ReverseScan(const std::string &table, const std::string &key, int len,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    return (this->*(method_reverse_scan_))(table, key, len, fields, result);
+  }
+
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    return (this->*(method_range_scan_))(table, start_key, end_key, fields, result);
+  }
+
   Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
     return (this->*(method_update_))(table, key, values);
   }
@@ -50,27 +78,80 @@ class RocksdbDB : public DB {
     return (this->*(method_delete_))(table, key);
   }
 
+  Status BulkLoad(const std::string &table, RecordStream &records);
+
+  void SubmitRead(const std::string &table, const std::string &key,
+                  const std::vector<std::string> *fields, std::vector<Field> *result,
+                  Completion done);
+
+  int Poll(int min_completions);
+
+  void PhaseBegin(const std::string &phase);
+
+  std::string StatusMsg();
+
+  void PhaseReport(std::ostream &out, const std::string &phase);
+
  private:
+  // the composite-key and wide-column reads share the instance's cached iterators and
+  // range bound, so the default async ops must run them inline
+  bool ThreadSafe() const { return format_ == kSingleRow; }
+
+  struct PerfStats;
+  class PerfScope;
+  struct PendingRead {
+    rocksdb::ColumnFamilyHandle *cf;
+    const std::string *key;
+    const std::vector<std::string> *fields;
+    std::vector<Field> *result;
+    Completion done;
+  };
+
+  typedef std::unordered_map<rocksdb::ColumnFamilyHandle *,
+                             std::unique_ptr<rocksdb::Iterator>> IteratorCache;
+
   enum RocksFormat {
     kSingleRow,
+    kRowMajor,
+    kColumnMajor,
+    kWideColumn,
   };
   RocksFormat format_;
 
   void GetOptions(const utils::Properties &props, rocksdb::Options *opt,
                   std::vector<rocksdb::ColumnFamilyDescriptor> *cf_descs);
-  static void SerializeRow(const std::vector<Field> &values, std::string &data);
-  static void DeserializeRowFilter(std::vector<Field> &values, const char *p, const char *lim,
-                                   const std::vector<std::string> &fields);
-  static void DeserializeRowFilter(std::vector<Field> &values, const std::string &data,
-                                   const std::vector<std::string> &fields);
-  static void DeserializeRow(std::vector<Field> &values, const char *p, const char *lim);
-  static void DeserializeRow(std::vector<Field> &values, const std::string &data);
+  static std::vector<uint64_t> PerfSnapshot();
+  rocksdb::Iterator *GetIterator(IteratorCache &cache, const rocksdb::ReadOptions &options,
+                                 rocksdb::ColumnFamilyHandle *cf);
+  rocksdb::ColumnFamilyHandle *GetColumnFamily(std::string_view table);
+
+  rocksdb::Status Get(rocksdb::ColumnFamilyHandle *cf, const rocksdb::Slice &key,
+                      rocksdb::PinnableSlice *value);
+
+  std::string BuildCompKey(const std::string &key, const std::string &field_name) const;
+  std::string KeyFromCompKey(const std::string &comp_key) const;
+  std::string FieldFromCompKey(const std::string &comp_key) const;
+  bool AddCompKeyField(const rocksdb::Iterator *db_iter, size_t len,
+                       const std::vector<std::string> *fields, std::string &row_key,
+                       std::vector<std::vector<Field>> &result) const;
+  Status MultiGetCompKeys(rocksdb::ColumnFamilyHandle *cf, const std::string &key,
+                          const std::vector<std::string> &fields, std::vector<Field> &result);
+  Status ScanColumns(const std::string &table, const std::string &key, size_t len,
+                     const std::string *end_key, bool reverse,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result);
 
   Status ReadSingle(const std::string &table, const std::string &key,
                     const std::vector<std::string> *fields, std::vector<Field> &result);
   Status ScanSingle(const std::string &table, const std::string &key, int len,
                     const std::vector<std::string> *fields,
                     std::vector<std::vector<Field>> &result);
+  Status ReverseScanSingle(const std::string &table, const std::string &key, int len,
+                           const std::vector<std::string> *fields,
+                           std::vector<std::vector<Field>> &result);
+  Status RangeScanSingle(const std::string &table, const std::string &start_key,
+                         const std::string &end_key, const std::vector<std::string> *fields,
+                         std::vector<std::vector<Field>> &result);
   Status UpdateSingle(const std::string &table, const std::string &key,
                       std::vector<Field> &values);
   Status MergeSingle(const std::string &table, const std::string &key,
@@ -79,11 +160,63 @@ class RocksdbDB : public DB {
                       std::vector<Field> &values);
   Status DeleteSingle(const std::string &table, const std::string &key);
 
+  Status ReadCompKeyRM(const std::string &table, const std::string &key,
+                       const std::vector<std::string> *fields, std::vector<Field> &result);
+  Status ScanCompKeyRM(const std::string &table, const std::string &key, int len,
+                       const std::vector<std::string> *fields,
+                       std::vector<std::vector<Field>> &result);
+  Status ReverseScanCompKeyRM(const std::string &table, const std::string &key, int len,
+                              const std::vector<std::string> *fields,
+                              std::vector<std::vector<Field>> &result);
+  Status RangeScanCompKeyRM(const std::string &table, const std::string &start_key,
+                            const std::string &end_key, const std::vector<std::string> *fields,
+                            std::vector<std::vector<Field>> &result);
+  Status ReadCompKeyCM(const std::string &table, const std::string &key,
+                       const std::vector<std::string> *fields, std::vector<Field> &result);
+  Status ScanCompKeyCM(const std::string &table, const std::string &key, int len,
+                       const std::vector<std::string> *fields,
+                       std::vector<std::vector<Field>> &result);
+  Status ReverseScanCompKeyCM(const std::string &table, const std::string &key, int len,
+                              const std::vector<std::string> *fields,
+                              std::vector<std::vector<Field>> &result);
+  Status RangeScanCompKeyCM(const std::string &table, const std::string &start_key,
+                            const std::string &end_key, const std::vector<std::string> *fields,
+                            std::vector<std::vector<Field>> &result);
+  void WriteCompKeys(const std::string &table, const std::string &key,
+                     const std::vector<Field> &values);
+  Status UpdateCompKey(const std::string &table, const std::string &key,
+                       std::vector<Field> &values);
+  Status InsertCompKey(const std::string &table, const std::string &key,
+                       std::vector<Field> &values);
+  Status DeleteCompKey(const std::string &table, const std::string &key);
+
+  Status ReadWide(const std::string &table, const std::string &key,
+                  const std::vector<std::string> *fields, std::vector<Field> &result);
+  Status ScanWide(const std::string &table, const std::string &key, int len,
+                  const std::vector<std::string> *fields,
+                  std::vector<std::vector<Field>> &result);
+  Status ReverseScanWide(const std::string &table, const std::string &key, int len,
+                         const std::vector<std::string> *fields,
+                         std::vector<std::vector<Field>> &result);
+  Status RangeScanWide(const std::string &table, const std::string &start_key,
+                       const std::string &end_key, const std::vector<std::string> *fields,
+                       std::vector<std::vector<Field>> &result);
+  Status UpdateWide(const std::string &table, const std::string &key,
+                    std::vector<Field> &values);
+  Status InsertWide(const std::string &table, const std::string &key,
+                    std::vector<Field> &values);
+
   Status (RocksdbDB::*method_read_)(const std::string &, const std:: string &,
                                     const std::vector<std::string> *, std::vector<Field> &);
   Status (RocksdbDB::*method_scan_)(const std::string &, const std::string &,
                                     int, const std::vector<std::string> *,
                                     std::vector<std::vector<Field>> &);
+  Status (RocksdbDB::*method_reverse_scan_)(const std::string &, const std::string &,
+                                            int, const std::vector<std::string> *,
+                                            std::vector<std::vector<Field>> &);
+  Status (RocksdbDB::*method_range_scan_)(const std::string &, const std::string &,
+                                          const std::string &, const std::vector<std::string> *,
+                                          std::vector<std::vector<Field>> &);
   Status (RocksdbDB::*method_update_)(const std::string &, const std::string &,
                                       std::vector<Field> &);
   Status (RocksdbDB::*method_insert_)(const std::string &, const std::string &,
@@ -91,10 +224,71 @@ class RocksdbDB : public DB {
   Status (RocksdbDB::*method_delete_)(const std::string &, const std::string &);
 
   int fieldcount_;
+  std::vector<std::string> field_names_; // every field, for column-major reads and deletes
+  RowCodec codec_;
+  rocksdb::PinnableSlice pinned_; // backs the views of the last ReadView
+  std::vector<PendingRead> pending_reads_; // submitted reads, issued together by the next Poll
+  bool async_io_;
+  bool merge_update_ = false;
+  rocksdb::ReadOptions scan_options_;
+  rocksdb::ReadOptions range_options_;
+  std::string scan_upper_bound_;
+  rocksdb::Slice scan_upper_bound_slice_;
+  rocksdb::Slice range_upper_bound_; // points at the end key of the current RangeScan
+  bool cache_iterators_;
+  IteratorCache scan_iterators_;     // per column family, for Scan and ReverseScan
+  IteratorCache range_iterators_;    // per column family, bounded by range_upper_bound_
+  std::shared_ptr<PerfStats> perf_; // nullptr unless rocksdb.perf_level is set
 
   static rocksdb::DB *db_;
+  static std::vector<rocksdb::ColumnFamilyHandle *> cf_handles_;
+  static std::vector<std::string> table_names_;
+  static std::vector<rocksdb::ColumnFamilyHandle *> table_cf_; // by table number, or nullptr
   static int ref_cnt_;
   static std::mutex mu_;
+  static std::vector<std::shared_ptr<PerfStats>> perf_stats_; // of every instance, under mu_
+  static rocksdb::WriteOptions write_options_; // of the current phase
+};
+
+///
+/// RocksdbDB compiled for rocksdb.format=single: each call goes straight to the
+/// *Single method instead of through the method pointers chosen in Init.
+///
+class RocksdbDB::SingleRow final : public RocksdbDB {
+ public:
+  Status Read(const std::string &table, const std::string &key,
+              const std::vector<std::string> *fields, std::vector<Field> &result) {
+    return ReadSingle(table, key, fields, result);
+  }
+
+  Status Scan(const std::string &table, const std::string &key, int len,
+              const std::vector<std::string> *fields, std::vector<std::vector<Field>> &result) {
+    return ScanSingle(table, key, len, fields, result);
+  }
+
+  Status ReverseScan(const std::string &table, const std::string &key, int len,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    return ReverseScanSingle(table, key, len, fields, result);
+  }
+
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    return RangeScanSingle(table, start_key, end_key, fields, result);
+  }
+
+  Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    return UpdateSingle(table, key, values);
+  }
+
+  Status Insert(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    return InsertSingle(table, key, values);
+  }
+
+  Status Delete(const std::string &table, const std::string &key) {
+    return DeleteSingle(table, key);
+  }
 };
 
 DB *NewRocksdbDB();
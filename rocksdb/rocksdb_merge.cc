@@ -0,0 +1,100 @@
+//
+//  rocksdb_merge.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#include "rocksdb_merge.h"
+
+#include <deque>
+
+namespace {
+
+// operands carry a subset of the fields, which only the length-prefixed layout encodes
+const ycsbc::RowCodec kOperandCodec;
+
+thread_local size_t merge_operands = 0;
+
+void Apply(const std::vector<ycsbc::DB::FieldView> &updates,
+           std::vector<ycsbc::DB::Field> *values) {
+  for (const ycsbc::DB::FieldView &update : updates) {
+    bool found = false;
+    for (ycsbc::DB::Field &field : *values) {
+      if (field.name == update.name) {
+        field.value.assign(update.value.data(), update.value.size());
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      values->push_back({std::string(update.name), std::string(update.value)});
+    }
+  }
+}
+
+class FieldMergeOperator : public rocksdb::MergeOperator {
+ public:
+  explicit FieldMergeOperator(const ycsbc::RowCodec &codec) : codec_(codec) {}
+
+  virtual bool FullMergeV2(const MergeOperationInput &merge_in,
+                           MergeOperationOutput *merge_out) const override {
+    std::vector<ycsbc::DB::Field> values;
+    if (merge_in.existing_value != nullptr) {
+      codec_.Decode(std::string_view(merge_in.existing_value->data(),
+                                     merge_in.existing_value->size()), &values);
+    }
+    std::vector<ycsbc::DB::FieldView> updates;
+    for (const rocksdb::Slice &operand : merge_in.operand_list) {
+      updates.clear();
+      kOperandCodec.Decode(std::string_view(operand.data(), operand.size()), &updates);
+      Apply(updates, &values);
+    }
+    merge_operands += merge_in.operand_list.size();
+    merge_out->new_value.clear();
+    codec_.Encode(values, &merge_out->new_value);
+    return true;
+  }
+
+  virtual bool PartialMergeMulti(const rocksdb::Slice &key,
+                                 const std::deque<rocksdb::Slice> &operand_list,
+                                 std::string *new_value, rocksdb::Logger *logger) const override {
+    std::vector<ycsbc::DB::Field> merged;
+    std::vector<ycsbc::DB::FieldView> updates;
+    for (const rocksdb::Slice &operand : operand_list) {
+      updates.clear();
+      kOperandCodec.Decode(std::string_view(operand.data(), operand.size()), &updates);
+      Apply(updates, &merged);
+    }
+    new_value->clear();
+    kOperandCodec.Encode(merged, new_value);
+    return true;
+  }
+
+  virtual const char *Name() const override {
+    return "YCSBFieldMerge";
+  }
+
+ private:
+  ycsbc::RowCodec codec_;
+};
+
+} // anonymous
+
+namespace ycsbc {
+
+std::shared_ptr<rocksdb::MergeOperator> NewFieldMergeOperator(const RowCodec &codec) {
+  return std::make_shared<FieldMergeOperator>(codec);
+}
+
+void EncodeMergeOperand(const std::vector<DB::Field> &values, std::string *operand) {
+  kOperandCodec.Encode(values, operand);
+}
+
+size_t TakeMergeOperandCount() {
+  size_t count = merge_operands;
+  merge_operands = 0;
+  return count;
+}
+
+} // ycsbc
@@ -0,0 +1,47 @@
+//
+//  rocksdb_merge.h
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+
+#ifndef YCSB_C_ROCKSDB_MERGE_H_
+#define YCSB_C_ROCKSDB_MERGE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/db.h"
+#include "core/row_codec.h"
+
+#include <rocksdb/merge_operator.h>
+
+namespace ycsbc {
+
+///
+/// Merge operator for field-level updates. An operand holds the updated fields,
+/// length-prefixed; they are applied over the stored row in order, later operands
+/// winning, and partial merges collapse consecutive operands into one.
+///
+/// Defined in its own translation unit, built without RTTI unless
+/// ROCKSDB_USE_RTTI=1: release builds of librocksdb carry no typeinfo for the
+/// MergeOperator it derives from.
+///
+std::shared_ptr<rocksdb::MergeOperator> NewFieldMergeOperator(const RowCodec &codec);
+
+///
+/// Encodes the fields of an update as a merge operand.
+///
+void EncodeMergeOperand(const std::vector<DB::Field> &values, std::string *operand);
+
+///
+/// Returns how many operands the full merges run on this thread since the last
+/// call applied, and starts counting again. A Get merges on the calling thread.
+///
+size_t TakeMergeOperandCount();
+
+} // ycsbc
+
+#endif // YCSB_C_ROCKSDB_MERGE_H_
@@ -0,0 +1,158 @@
+//
+//  flight_recorder_test.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+//  Behaviour check of the flight recorder windows: an outlier is dumped with
+//  the ops around it, outliers inside a pending window are covered by it, a
+//  pending window is written on destruction, and reading the dump keeps the
+//  ops that overlapping windows share once.
+//
+//  Usage: flight_recorder_test
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "core/flight_recorder.h"
+#include "core/utils.h"
+
+using ycsbc::FlightDumpHeader;
+using ycsbc::FlightRecord;
+using ycsbc::FlightRecorder;
+
+namespace {
+
+size_t checks = 0;
+size_t failures = 0;
+
+void Check(bool ok, const std::string &what) {
+  checks++;
+  if (!ok) {
+    failures++;
+    fprintf(stderr, "FAILED: %s\n", what.c_str());
+  }
+}
+
+const uint64_t kThresholdNs = 100;
+const uint64_t kOutlierNs = 1000;
+const size_t kCapacity = 8;
+const int kOps = 30;
+
+// Records kOps ops issued 10 ns apart; the ops listed in outliers take longer
+// than the threshold.
+void Run(FlightRecorder *recorder, const std::set<int> &outliers) {
+  for (int i = 0; i < kOps; i++) {
+    recorder->Record(0, 0, "user" + std::to_string(i), i * 10,
+                     outliers.count(i) ? kOutlierNs : 1);
+  }
+}
+
+} // anonymous
+
+int main() {
+  char path[] = "/tmp/flight_recorder_testXXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+
+  {
+    // windows of ops 7..14 (the outlier at 12 is covered) and 13..20, then a
+    // window of ops 22..29 still pending when the recorder is destroyed
+    FlightRecorder a(path, kCapacity, kThresholdNs);
+    // a single window of ops 2..9
+    FlightRecorder b(path, kCapacity, kThresholdNs);
+    Run(&a, {10, 12, 16, 28});
+    Run(&b, {5});
+  }
+
+  std::vector<FlightRecord> records;
+  FlightDumpHeader last = {};
+  size_t windows = 0;
+  try {
+    windows = ycsbc::ReadFlightDump(path, &records, &last);
+  } catch (const ycsbc::utils::Exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    unlink(path);
+    return 1;
+  }
+  Check(windows == 4, "4 windows, read " + std::to_string(windows));
+  Check(last.threshold_ns == kThresholdNs, "header threshold");
+
+  // recorder ids come from a process-wide counter; only b ran ops at 20 ns
+  // and only a at 220 ns
+  uint32_t thread_a = 0;
+  uint32_t thread_b = 0;
+  for (const FlightRecord &r : records) {
+    if (r.start_ns == 20) {
+      thread_b = r.thread;
+    } else if (r.start_ns == 220) {
+      thread_a = r.thread;
+    }
+  }
+  std::set<uint64_t> starts_a;
+  std::set<uint64_t> starts_b;
+  bool sorted = true;
+  bool latencies = true;
+  for (size_t i = 0; i < records.size(); i++) {
+    const FlightRecord &r = records[i];
+    if (i > 0 && records[i - 1].start_ns > r.start_ns) {
+      sorted = false;
+    }
+    std::set<uint64_t> &starts = r.thread == thread_b ? starts_b : starts_a;
+    Check(starts.insert(r.start_ns).second,
+          "op at " + std::to_string(r.start_ns) + " kept once");
+    latencies = latencies && r.latency_ns == (r.latency_ns > kThresholdNs ? kOutlierNs : 1);
+  }
+  Check(sorted, "records ordered by start time");
+  Check(latencies, "latencies preserved");
+  Check(records.size() == 30, "30 distinct ops, read " + std::to_string(records.size()));
+
+  std::set<uint64_t> expected_a;
+  for (int i = 7; i <= 20; i++) {
+    expected_a.insert(i * 10);
+  }
+  for (int i = 22; i <= 29; i++) {
+    expected_a.insert(i * 10);
+  }
+  std::set<uint64_t> expected_b;
+  for (int i = 2; i <= 9; i++) {
+    expected_b.insert(i * 10);
+  }
+  Check(thread_a != thread_b, "two threads in the dump");
+  Check(starts_a == expected_a, "windows of the first thread");
+  Check(starts_b == expected_b, "window of the second thread");
+
+  size_t outliers = 0;
+  for (const FlightRecord &r : records) {
+    outliers += r.latency_ns > kThresholdNs;
+  }
+  Check(outliers == 5, "all outliers dumped");
+
+  // a window cut short is reported rather than read as records
+  if (truncate(path, sizeof(FlightDumpHeader) + sizeof(FlightRecord)) != 0) {
+    perror("truncate");
+  }
+  bool threw = false;
+  try {
+    records.clear();
+    ycsbc::ReadFlightDump(path, &records, &last);
+  } catch (const ycsbc::utils::Exception &) {
+    threw = true;
+  }
+  Check(threw, "truncated dump throws");
+  unlink(path);
+
+  printf("flight_recorder_test: %zu checks, %zu failed\n", checks, failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+//
+//  flight_dump.cc
+//  YCSB-cpp
+//
+//  Copyright 2023 Chengye YU <yuchengye2013 AT outlook.com>.
+//
+//  Reads the windows written by the flight recorder (flightrecorder.threshold_us)
+//  and groups the outliers of all client threads into incidents: outliers whose
+//  spans overlap, or lie within the slack of each other, on any thread. For each
+//  incident it lists the outliers and what every thread was doing meanwhile.
+//
+//  Usage: flight_dump <file> [slack_us]
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "core/core_workload.h"
+#include "core/flight_recorder.h"
+#include "core/utils.h"
+
+using ycsbc::FlightDumpHeader;
+using ycsbc::FlightRecord;
+
+namespace {
+
+const char *OpName(uint8_t op) {
+  return op < ycsbc::MAXOPTYPE ? ycsbc::kOperationString[op] : "?";
+}
+
+// TscClock timestamps are process-relative; the dump headers anchor them to wall time
+std::string WallTime(uint64_t clock_ns, const FlightDumpHeader &anchor) {
+  uint64_t wall_ns = anchor.wall_ns - (anchor.clock_ns - clock_ns);
+  time_t secs = wall_ns / 1000000000;
+  char buf[32];
+  strftime(buf, sizeof(buf), "%F %T", localtime(&secs));
+  char out[48];
+  snprintf(out, sizeof(out), "%s.%06llu", buf,
+           static_cast<unsigned long long>(wall_ns % 1000000000 / 1000));
+  return out;
+}
+
+} // anonymous
+
+int main(int argc, const char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <file> [slack_us]\n", argv[0]);
+    return 1;
+  }
+  const uint64_t slack_ns = argc > 2 ? std::stoull(argv[2]) * 1000 : 1000000;
+
+  std::vector<FlightRecord> records;
+  FlightDumpHeader anchor = {};
+  size_t dumps;
+  try {
+    dumps = ycsbc::ReadFlightDump(argv[1], &records, &anchor);
+  } catch (const ycsbc::utils::Exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  const uint64_t threshold_ns = anchor.threshold_ns;
+  printf("%zu windows, %zu distinct ops, threshold %.3f ms\n", dumps, records.size(),
+         threshold_ns / 1e6);
+
+  std::vector<const FlightRecord *> outliers;
+  for (const FlightRecord &record : records) {
+    if (record.latency_ns > threshold_ns) {
+      outliers.push_back(&record);
+    }
+  }
+
+  size_t i = 0;
+  int incident = 0;
+  while (i < outliers.size()) {
+    uint64_t begin = outliers[i]->start_ns;
+    uint64_t end = begin + outliers[i]->latency_ns;
+    size_t j = i + 1;
+    while (j < outliers.size() && outliers[j]->start_ns <= end + slack_ns) {
+      end = std::max(end, outliers[j]->start_ns + outliers[j]->latency_ns);
+      j++;
+    }
+
+    printf("\nincident %d: %s, %.3f ms, %zu outliers\n", ++incident,
+           WallTime(begin, anchor).c_str(), (end - begin) / 1e6, j - i);
+    for (size_t k = i; k < j; k++) {
+      const FlightRecord &r = *outliers[k];
+      printf("  +%10.3f ms  thread %-3u %-20s key %016llx  %10.3f ms\n",
+             (r.start_ns - begin) / 1e6, r.thread, OpName(r.op),
+             static_cast<unsigned long long>(r.key_hash), r.latency_ns / 1e6);
+    }
+
+    // every op that was running at some point of the incident, per thread
+    struct Activity {
+      size_t ops = 0;
+      uint64_t max_ns = 0;
+      std::map<std::string, size_t> by_op;
+    };
+    std::map<uint32_t, Activity> threads;
+    for (const FlightRecord &r : records) {
+      if (r.start_ns > end) {
+        break;
+      }
+      if (r.start_ns + r.latency_ns < begin) {
+        continue;
+      }
+      Activity &activity = threads[r.thread];
+      activity.ops++;
+      activity.max_ns = std::max(activity.max_ns, r.latency_ns);
+      activity.by_op[OpName(r.op)]++;
+    }
+    for (const auto &thread : threads) {
+      printf("  thread %-3u %6zu ops, max %10.3f ms:", thread.first, thread.second.ops,
+             thread.second.max_ns / 1e6);
+      for (const auto &op : thread.second.by_op) {
+        printf(" %s=%zu", op.first.c_str(), op.second);
+      }
+      printf("\n");
+    }
+    i = j;
+  }
+  return 0;
+}
@@ -5,6 +5,8 @@
 #include "core/properties.h"
 #include "core/utils.h"
 
+#include <algorithm>
+
 namespace {
   const std::string PROP_NAME = "treeline.dbname";
   const std::string PROP_NAME_DEFAULT = "/tmp/ycsb-treelinedb";
@@ -59,6 +61,9 @@ namespace {
 
   const std::string PROP_REC_CACHE_USE_LRU = "treeline.rec_cache_use_lru";
   const std::string PROP_REC_CACHE_USE_LRU_DEFAULT = "0";
+
+  const std::string PROP_BULK_LOAD_BATCH = "treeline.bulkload_batch";
+  const std::string PROP_BULK_LOAD_BATCH_DEFAULT = "1048576";
 } // anonymous
 
 namespace ycsbc {
@@ -66,11 +71,6 @@ namespace ycsbc {
   int TreeLineDB::ref_cnt_ = 0;
   std::mutex TreeLineDB::mu_;
 
-  typedef union{
-      uint64_t key_num;
-      char key_char[8];
-  } convert;
-
   void TreeLineDB::Init(){
     const std::lock_guard<std::mutex> lock(mu_);
 
@@ -80,6 +80,7 @@ namespace ycsbc {
       format_ = kSingleRow;
       method_read_ = &TreeLineDB::ReadSingle;
       method_scan_ = &TreeLineDB::ScanSingle;
+      method_range_scan_ = &TreeLineDB::RangeScanSingle;
       method_update_ = &TreeLineDB::UpdateSingle;
       method_insert_ = &TreeLineDB::InsertSingle;
       method_delete_ = &TreeLineDB::DeleteSingle;
@@ -87,6 +88,17 @@ namespace ycsbc {
       throw utils::Exception("unknown format");
     }
     fieldcount_ = std::stoi(props.GetProperty(CoreWorkload::FIELD_COUNT_PROPERTY, CoreWorkload::FIELD_COUNT_DEFAULT));
+    codec_ = RowCodec::FromProperties(props);
+    key_encoding_ = CoreWorkload::GetKeyEncoding(props);
+    bulk_load_batch_ = std::stoul(props.GetProperty(PROP_BULK_LOAD_BATCH,
+                                                     PROP_BULK_LOAD_BATCH_DEFAULT));
+    if (bulk_load_batch_ == 0) {
+      throw utils::Exception(PROP_BULK_LOAD_BATCH + " must be positive");
+    }
+    // a single integer-keyed index, there is no namespace to map extra tables to
+    if (CoreWorkload::TableNames(props).size() > 1) {
+      throw utils::Exception("TreeLine supports a single table only");
+    }
 
     ref_cnt_++;
     if (db_) {
@@ -114,7 +126,10 @@ namespace ycsbc {
     tl::pg::PageGroupedDBStats::RunOnGlobal([](auto& global_stats) { global_stats.Reset(); });
     s = tl::pg::PageGroupedDB::Open(opts, db_path, &db_);
 
-    if (empty) {
+    // a bulk load phase fills the empty db with the real records instead
+    const bool bulk_load = props.GetProperty(CoreWorkload::LOAD_MODE_PROPERTY,
+                                             CoreWorkload::LOAD_MODE_DEFAULT) == "bulk";
+    if (empty && !bulk_load) {
       std::vector<tl::pg::Record> records;
       records.reserve(1024*1024);
       std::cout << "Start generating" << std::endl;
@@ -188,86 +203,22 @@ namespace ycsbc {
     opts->forecasting.num_future_epochs = 1;
   }
 
-  void TreeLineDB::SerializeRow(const std::vector<Field> &values, std::string &data) {
-    for (const Field &field : values) {
-      uint32_t len = field.name.size();
-      data.append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-      data.append(field.name.data(), field.name.size());
-      len = field.value.size();
-      data.append(reinterpret_cast<char *>(&len), sizeof(uint32_t));
-      data.append(field.value.data(), field.value.size());
-    }
-  }
-
-  void TreeLineDB::DeserializeRowFilter(std::vector<Field> &values, const char *p, const char *lim,
-                                      const std::vector<std::string> &fields) {
-    std::vector<std::string>::const_iterator filter_iter = fields.begin();
-    while (p != lim && filter_iter != fields.end()) {
-      assert(p < lim);
-      uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-      p += sizeof(uint32_t);
-      std::string field(p, static_cast<const size_t>(len));
-      p += len;
-      len = *reinterpret_cast<const uint32_t *>(p);
-      p += sizeof(uint32_t);
-      std::string value(p, static_cast<const size_t>(len));
-      p += len;
-      if (*filter_iter == field) {
-        values.push_back({field, value});
-        filter_iter++;
-      }
-    }
-    assert(values.size() == fields.size());
-  }
-
-  void TreeLineDB::DeserializeRowFilter(std::vector<Field> &values, const std::string &data,
-                                      const std::vector<std::string> &fields) {
-    const char *p = data.data();
-    const char *lim = p + data.size();
-    DeserializeRowFilter(values, p, lim, fields);
-  }
-
-  void TreeLineDB::DeserializeRow(std::vector<Field> &values, const char *p, const char *lim) {
-    while (p != lim) {
-      assert(p < lim);
-      uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-      p += sizeof(uint32_t);
-      std::string field(p, static_cast<const size_t>(len));
-      p += len;
-      len = *reinterpret_cast<const uint32_t *>(p);
-      p += sizeof(uint32_t);
-      std::string value(p, static_cast<const size_t>(len));
-      p += len;
-      values.push_back({field, value});
-    }
-  }
-
-  void TreeLineDB::DeserializeRow(std::vector<Field> &values, const std::string &data) {
-    const char *p = data.data();
-    const char *lim = p + data.size();
-    DeserializeRow(values, p, lim);
-  }
-
   DB::Status TreeLineDB::ReadSingle(const std::string &table, const std::string &key, const std::vector<std::string> *fields, std::vector<Field> &result)
   {
 
     std::string data;
     //tl::ReadOptions options;
-    convert c;
-    for (int i = 0; i < 8; i++) {
-      c.key_char[i] = key.c_str()[i];
-    }
-    tl::Status s = db_->Get(c.key_num, &data);
+    tl::pg::Key key_num = DecodeKeyNum(key.data(), key.size(), key_encoding_);
+    tl::Status s = db_->Get(key_num, &data);
     if (s.IsNotFound()) {
-      std::cout << c.key_num << std::endl;
       return kNotFound;
     } else if (!s.ok()) {
       throw utils::Exception(std::string("TreeLineDB Get: ") + s.ToString());
     }
     if (fields != nullptr) {
-      DeserializeRowFilter(result, data, *fields);
+      codec_.DecodeFilter(data, *fields, &result);
     } else {
-      DeserializeRow(result, data);
+      codec_.Decode(data, &result);
       assert(result.size() == static_cast<size_t>(fieldcount_));
     }
     return kOK;
@@ -276,33 +227,61 @@ namespace ycsbc {
   DB::Status TreeLineDB::ScanSingle(const std::string &table, const std::string &key, int len, const std::vector<std::string> *fields, std::vector<std::vector<Field>> &result)
   {
     std::vector<std::pair<tl::pg::Key, std::string>> scan_out;
-    convert c;
-    for (int i = 0; i < 8; i++) {
-      c.key_char[i] = key.c_str()[i];
-    }
-    tl::Status status = db_->GetRange(c.key_num, len, &scan_out);
+    tl::pg::Key key_num = DecodeKeyNum(key.data(), key.size(), key_encoding_);
+    tl::Status status = db_->GetRange(key_num, len, &scan_out);
     for (auto& record : scan_out) {
       std::string data = record.second;
       result.push_back(std::vector<Field>());
       std::vector<Field> &values = result.back();
       if (fields != nullptr) {
-        DeserializeRowFilter(values, data, *fields);
+        codec_.DecodeFilter(data, *fields, &values);
       } else {
-        DeserializeRow(values, data);
+        codec_.Decode(data, &values);
         assert(values.size() == static_cast<size_t>(fieldcount_));
       }
     }
     return kOK;
   }
 
+  DB::Status TreeLineDB::RangeScanSingle(const std::string &table, const std::string &start_key, const std::string &end_key, const std::vector<std::string> *fields, std::vector<std::vector<Field>> &result)
+  {
+    // GetRange takes a record count, so fetch in chunks until the end key is passed
+    constexpr size_t kChunk = 64;
+    tl::pg::Key next_key = DecodeKeyNum(start_key.data(), start_key.size(), key_encoding_);
+    const tl::pg::Key end_num = DecodeKeyNum(end_key.data(), end_key.size(), key_encoding_);
+    std::vector<std::pair<tl::pg::Key, std::string>> scan_out;
+    while (next_key < end_num) {
+      scan_out.clear();
+      tl::Status status = db_->GetRange(next_key, kChunk, &scan_out);
+      if (!status.ok()) {
+        throw utils::Exception(std::string("TreeLine GetRange: ") + status.ToString());
+      }
+      for (auto& record : scan_out) {
+        if (record.first >= end_num) {
+          return kOK;
+        }
+        result.push_back(std::vector<Field>());
+        std::vector<Field> &values = result.back();
+        if (fields != nullptr) {
+          codec_.DecodeFilter(record.second, *fields, &values);
+        } else {
+          codec_.Decode(record.second, &values);
+          assert(values.size() == static_cast<size_t>(fieldcount_));
+        }
+      }
+      if (scan_out.size() < kChunk) {
+        break;
+      }
+      next_key = scan_out.back().first + 1;
+    }
+    return kOK;
+  }
+
   DB::Status TreeLineDB::UpdateSingle(const std::string &table, const std::string &key, std::vector<Field> &values)
   {
     std::string data;
-    convert c;
-    for (int i = 0; i < 8; i++) {
-      c.key_char[i] = key.c_str()[i];
-    }
-    // tl::Status s = db_->Get(c.key_num, &data);
+    tl::pg::Key key_num = DecodeKeyNum(key.data(), key.size(), key_encoding_);
+    // tl::Status s = db_->Get(key_num, &data);
     // if (s.IsNotFound()) {
     //   return kNotFound;
     // } else if (!s.ok()) {
@@ -323,8 +302,8 @@ namespace ycsbc {
     // }
     tl::pg::WriteOptions write_options;
     write_options.is_update = true;
-    SerializeRow(values, data);
-    tl::Status s = db_->Put(write_options, c.key_num, data);
+    codec_.Encode(values, &data);
+    tl::Status s = db_->Put(write_options, key_num, data);
     if (!s.ok()) {
       throw utils::Exception(std::string("TreeLine Put: ") + s.ToString());
     }
@@ -334,21 +313,64 @@ namespace ycsbc {
   DB::Status TreeLineDB::InsertSingle(const std::string &table, const std::string &key, std::vector<Field> &values)
   {
     std::string data;
-    convert c;
-    for (int i = 0; i < 8; i++) {
-      c.key_char[i] = key.c_str()[i];
-    }
-    SerializeRow(values, data);
+    tl::pg::Key key_num = DecodeKeyNum(key.data(), key.size(), key_encoding_);
+    codec_.Encode(values, &data);
     size_t value_len = data.size();
     tl::pg::WriteOptions write_options;
     write_options.is_update = false;
-    tl::Status s = db_->Put(write_options, c.key_num, data);
+    tl::Status s = db_->Put(write_options, key_num, data);
     if (!s.ok()) {
       throw utils::Exception(std::string("TreeLine Put: ") + s.ToString());
     }
     return kOK;
   }
 
+  // PageGroupedDB orders records by the integer key, which the byte order of the
+  // stream need not follow, so the records are read and sorted in bounded batches. The
+  // first batch lays out the page groups through PageGroupedDB::BulkLoad, as the synthetic
+  // keys do for a regular load, and the later ones are inserted into them.
+  DB::Status TreeLineDB::BulkLoad(const std::string &table, RecordStream &records) {
+    std::vector<std::pair<tl::pg::Key, std::string>> rows;
+    std::string key;
+    std::vector<Field> values;
+    bool loaded = false;
+    bool more = true;
+    while (more) {
+      rows.clear();
+      while (rows.size() < bulk_load_batch_ && (more = records.Next(&key, &values))) {
+        std::string data;
+        codec_.Encode(values, &data);
+        rows.emplace_back(DecodeKeyNum(key.data(), key.size(), key_encoding_), std::move(data));
+      }
+      if (rows.empty()) {
+        break;
+      }
+      std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+      });
+      tl::Status s;
+      if (!loaded) {
+        std::vector<tl::pg::Record> batch;
+        batch.reserve(rows.size());
+        for (const auto &row : rows) {
+          batch.emplace_back(row.first, tl::Slice(row.second));
+        }
+        s = db_->BulkLoad(batch);
+        loaded = true;
+      } else {
+        tl::pg::WriteOptions write_options;
+        write_options.is_update = false;
+        for (size_t i = 0; i < rows.size() && s.ok(); i++) {
+          s = db_->Put(write_options, rows[i].first, rows[i].second);
+        }
+      }
+      if (!s.ok()) {
+        throw utils::Exception(std::string("TreeLine BulkLoad: ") + s.ToString());
+      }
+    }
+    return kOK;
+  }
+
   DB::Status TreeLineDB::DeleteSingle(const std::string &table, const std::string &key)
   {
     // tl::WriteOptions write_options;
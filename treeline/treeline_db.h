@@ -10,7 +10,9 @@
 #include <mutex>
 
 #include "core/db.h"
+#include "core/key_codec.h"
 #include "core/properties.h"
+#include "core/row_codec.h"
 
 #include <treeline/pg_db.h>
 #include <treeline/pg_stats.h>
@@ -36,6 +38,13 @@ class TreeLineDB : public DB {
     return (this->*(method_scan_))(table, key, len, fields, result);
   }
 
+  // PageGroupedDB only iterates forward, so ReverseScan keeps the kNotImplemented default
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    return (this->*(method_range_scan_))(table, start_key, end_key, fields, result);
+  }
+
   Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
     return (this->*(method_update_))(table, key, values);
   }
@@ -48,6 +57,8 @@ class TreeLineDB : public DB {
     return (this->*(method_delete_))(table, key);
   }
 
+  Status BulkLoad(const std::string &table, RecordStream &records);
+
  private:
   enum RocksFormat {
     kSingleRow,
@@ -56,19 +67,14 @@ class TreeLineDB : public DB {
 
   void GetOptions(const utils::Properties &props, tl::pg::PageGroupedDBOptions *opts);
 
-  static void SerializeRow(const std::vector<Field> &values, std::string &data);
-  static void DeserializeRowFilter(std::vector<Field> &values, const char *p, const char *lim,
-                                   const std::vector<std::string> &fields);
-  static void DeserializeRowFilter(std::vector<Field> &values, const std::string &data,
-                                   const std::vector<std::string> &fields);
-  static void DeserializeRow(std::vector<Field> &values, const char *p, const char *lim);
-  static void DeserializeRow(std::vector<Field> &values, const std::string &data);
-
   Status ReadSingle(const std::string &table, const std::string &key,
                     const std::vector<std::string> *fields, std::vector<Field> &result);
   Status ScanSingle(const std::string &table, const std::string &key, int len,
                     const std::vector<std::string> *fields,
                     std::vector<std::vector<Field>> &result);
+  Status RangeScanSingle(const std::string &table, const std::string &start_key,
+                         const std::string &end_key, const std::vector<std::string> *fields,
+                         std::vector<std::vector<Field>> &result);
   Status UpdateSingle(const std::string &table, const std::string &key,
                       std::vector<Field> &values);
   Status InsertSingle(const std::string &table, const std::string &key,
@@ -80,6 +86,9 @@ class TreeLineDB : public DB {
   Status (TreeLineDB::*method_scan_)(const std::string &, const std::string &,
                                     int, const std::vector<std::string> *,
                                     std::vector<std::vector<Field>> &);
+  Status (TreeLineDB::*method_range_scan_)(const std::string &, const std::string &,
+                                          const std::string &, const std::vector<std::string> *,
+                                          std::vector<std::vector<Field>> &);
   Status (TreeLineDB::*method_update_)(const std::string &, const std::string &,
                                       std::vector<Field> &);
   Status (TreeLineDB::*method_insert_)(const std::string &, const std::string &,
@@ -87,6 +96,9 @@ class TreeLineDB : public DB {
   Status (TreeLineDB::*method_delete_)(const std::string &, const std::string &);
 
   int fieldcount_;
+  RowCodec codec_;
+  KeyEncoding key_encoding_;
+  size_t bulk_load_batch_; // records sorted and loaded at a time by BulkLoad
 
   static tl::pg::PageGroupedDB *db_;
   uint64_t min_key_, max_key_, num_keys_;
@@ -7,6 +7,7 @@
 #include <string>
 #include <iostream>
 #include <set>
+#include <algorithm>
 #include <sys/stat.h>
 #if defined(_MSC_VER)
 #include "direct.h"
@@ -16,6 +17,7 @@
 #include "core/properties.h"
 #include "core/utils.h"
 #include "core/core_workload.h"
+#include "core/client.h"
 #include "core/db_factory.h"
 
 #include "wiredtiger_db.h"
@@ -81,6 +83,10 @@ namespace {
 
   const std::string PROP_BLK_MGR_BTREE_LEAF_PAGE_MAX = WT_PREFIX ".blk_mgr.btree.leaf_page_max";
   const std::string PROP_BLK_MGR_BTREE_LEAF_PAGE_MAX_DEFAULT = "";
+
+  inline std::string_view ItemView(const WT_ITEM &item) {
+    return std::string_view(static_cast<const char *>(item.data), item.size);
+  }
 }
 
 namespace ycsbc {
@@ -96,10 +102,13 @@ void WTDB::Init(){
   const std::string &format = props.GetProperty(PROP_FORMAT, PROP_FORMAT_DEFAULT);
   fieldcount_ = std::stoi(props.GetProperty(CoreWorkload::FIELD_COUNT_PROPERTY,
                                             CoreWorkload::FIELD_COUNT_DEFAULT));
+  codec_ = RowCodec::FromProperties(props);
 
   if(format=="single"){
     method_read_ = &WTDB::ReadSingleEntry;
     method_scan_ = &WTDB::ScanSingleEntry;
+    method_reverse_scan_ = &WTDB::ReverseScanSingleEntry;
+    method_range_scan_ = &WTDB::RangeScanSingleEntry;
     method_update_ = &WTDB::UpdateSingleEntry;
     method_insert_ = &WTDB::InsertSingleEntry;
     method_delete_ = &WTDB::DeleteSingleEntry;
@@ -107,10 +116,16 @@ void WTDB::Init(){
     throw utils::Exception("single ONLY");
   }
 
+  const std::vector<std::string> tables = CoreWorkload::TableNames(props);
+
   ref_cnt_++;
   if(conn_){
     error_check(conn_->open_session(conn_, NULL, NULL, &session_));
-    error_check(session_->open_cursor(session_, "table:ycsbc", NULL, "overwrite=true", &cursor_));
+    for (const std::string &table : tables) {
+      const std::string uri = TableUri(table, tables.size());
+      error_check(session_->open_cursor(session_, uri.c_str(), NULL, "overwrite=true", &cursor_));
+      if (tables.size() > 1) table_cursors_[table] = cursor_;
+    }
     return;
   }
 
@@ -188,16 +203,33 @@ void WTDB::Init(){
       if(!leaf_page_max.empty())      table_config += "leaf_page_max=" + leaf_page_max;
     }
     std::cout<<"table config: "<<table_config<<std::endl;
-    error_check(session_->create(session_, "table:ycsbc", table_config.c_str()));
+    for (const std::string &table : tables) {
+      error_check(session_->create(session_, TableUri(table, tables.size()).c_str(), table_config.c_str()));
+    }
+  }
+
+  // Open cursor (per thread, per table)
+  for (const std::string &table : tables) {
+    const std::string uri = TableUri(table, tables.size());
+    error_check(session_->open_cursor(session_, uri.c_str(), NULL, "overwrite=true", &cursor_));
+    if (tables.size() > 1) table_cursors_[table] = cursor_;
   }
+}
 
-  // Open cursor (per thread)
-  error_check(session_->open_cursor(session_, "table:ycsbc", NULL, "overwrite=true", &cursor_));
+std::string WTDB::TableUri(const std::string &table, size_t table_count) {
+  // a single table keeps the historical name so existing homes stay readable
+  return table_count > 1 ? "table:" + table : "table:ycsbc";
 }
 
 void WTDB::Cleanup(){
   const std::lock_guard<std::mutex> lock(mu_);
-  cursor_->close(cursor_);
+  if (table_cursors_.empty()) {
+    cursor_->close(cursor_);
+  }
+  for (auto &table_cursor : table_cursors_) {
+    table_cursor.second->close(table_cursor.second);
+  }
+  table_cursors_.clear();
   error_check(session_->close(session_, NULL));
   if (--ref_cnt_) {
     return;
@@ -208,21 +240,22 @@ void WTDB::Cleanup(){
 DB::Status WTDB::ReadSingleEntry(const std::string &table, const std::string &key,
                                       const std::vector<std::string> *fields,
                                       std::vector<Field> &result) {
+  WT_CURSOR *cursor = GetCursor(table);
   WT_ITEM k = {key.data(), key.size()};
   WT_ITEM v;
   int ret;
-  cursor_->set_key(cursor_, &k);
-  ret = cursor_->search(cursor_);
+  cursor->set_key(cursor, &k);
+  ret = cursor->search(cursor);
   if(ret==WT_NOTFOUND){
     return kNotFound;
   } else if(ret != 0) {
     throw utils::Exception(WT_PREFIX " search error");
   }
-  error_check(cursor_->get_value(cursor_, &v));
+  error_check(cursor->get_value(cursor, &v));
   if (fields != nullptr) {
-    DeserializeRowFilter(&result, (const char*)v.data, v.size, *fields);
+    codec_.DecodeFilter(ItemView(v), *fields, &result);
   } else {
-    DeserializeRow(&result, (const char*)v.data, v.size);
+    codec_.Decode(ItemView(v), &result);
   }
   return kOK;
 }
@@ -230,43 +263,127 @@ DB::Status WTDB::ReadSingleEntry(const std::string &table, const std::string &ke
 DB::Status WTDB::ScanSingleEntry(const std::string &table, const std::string &key, int len,
                                       const std::vector<std::string> *fields,
                                       std::vector<std::vector<Field>> &result) {
+  return ScanVisit(table, key, len, fields, [&result](const std::vector<FieldView> &record) {
+    AppendRecord(record, result);
+    return true;
+  });
+}
+
+DB::Status WTDB::ScanVisit(std::string_view table, std::string_view key, int len,
+                           const std::vector<std::string> *fields, const ScanVisitor &visitor) {
+  WT_CURSOR *cursor = GetCursor(std::string(table));
   WT_ITEM k = {key.data(), key.size()};
   WT_ITEM v;
   int ret = 0, exact;
+  // the views point into the cursor's current value, valid until it moves
+  std::vector<FieldView> record;
 
-  cursor_->set_key(cursor_, &k);
-  error_check(cursor_->search_near(cursor_, &exact));
+  cursor->set_key(cursor, &k);
+  error_check(cursor->search_near(cursor, &exact));
   if (exact < 0) {
-    ret = cursor_->next(cursor_);
+    ret = cursor->next(cursor);
   }
   for(int i=0; !ret && i<len; ++i){
-    error_check(cursor_->get_value(cursor_, &v));
+    error_check(cursor->get_value(cursor, &v));
+    record.clear();
+    if (fields != nullptr) {
+      codec_.DecodeFilter(ItemView(v), *fields, &record);
+    } else {
+      codec_.Decode(ItemView(v), &record);
+    }
+    if (!visitor(record)) {
+      break;
+    }
+    ret = cursor->next(cursor);
+  }
+  error_check(cursor->reset(cursor));
+  return kOK;
+}
+
+DB::Status WTDB::ReverseScanSingleEntry(const std::string &table, const std::string &key,
+                                        int len, const std::vector<std::string> *fields,
+                                        std::vector<std::vector<Field>> &result) {
+  WT_CURSOR *cursor = GetCursor(table);
+  WT_ITEM k = {key.data(), key.size()};
+  WT_ITEM v;
+  int ret, exact;
+
+  cursor->set_key(cursor, &k);
+  ret = cursor->search_near(cursor, &exact);
+  if (ret == 0 && exact > 0) {
+    ret = cursor->prev(cursor);
+  }
+  for (int i = 0; !ret && i < len; ++i) {
+    error_check(cursor->get_value(cursor, &v));
+    result.emplace_back(std::vector<Field>());
+    if (fields != nullptr) {
+      codec_.DecodeFilter(ItemView(v), *fields, &result.back());
+    } else {
+      codec_.Decode(ItemView(v), &result.back());
+    }
+    ret = cursor->prev(cursor);
+  }
+  if (ret != 0 && ret != WT_NOTFOUND) {
+    throw utils::Exception(WT_PREFIX " reverse scan error");
+  }
+  error_check(cursor->reset(cursor));
+  return kOK;
+}
+
+DB::Status WTDB::RangeScanSingleEntry(const std::string &table, const std::string &start_key,
+                                      const std::string &end_key,
+                                      const std::vector<std::string> *fields,
+                                      std::vector<std::vector<Field>> &result) {
+  WT_CURSOR *cursor = GetCursor(table);
+  WT_ITEM k = {start_key.data(), start_key.size()};
+  WT_ITEM v;
+  int ret, exact;
+
+  cursor->set_key(cursor, &k);
+  ret = cursor->search_near(cursor, &exact);
+  if (ret == 0 && exact < 0) {
+    ret = cursor->next(cursor);
+  }
+  while (!ret) {
+    error_check(cursor->get_key(cursor, &k));
+    // default collator: bytewise, a proper prefix sorts first
+    int cmp = memcmp(k.data, end_key.data(), std::min(k.size, end_key.size()));
+    if (cmp > 0 || (cmp == 0 && k.size >= end_key.size())) {
+      break;
+    }
+    error_check(cursor->get_value(cursor, &v));
     result.emplace_back(std::vector<Field>());
     if (fields != nullptr) {
-      DeserializeRowFilter(&result.back(), (const char*)v.data, v.size, *fields);
+      codec_.DecodeFilter(ItemView(v), *fields, &result.back());
     } else {
-      DeserializeRow(&result.back(), (const char*)v.data, v.size);
+      codec_.Decode(ItemView(v), &result.back());
     }
+    ret = cursor->next(cursor);
   }
+  if (ret != 0 && ret != WT_NOTFOUND) {
+    throw utils::Exception(WT_PREFIX " range scan error");
+  }
+  error_check(cursor->reset(cursor));
   return kOK;
 }
 
 DB::Status WTDB::UpdateSingleEntry(const std::string &table, const std::string &key,
                            std::vector<Field> &values){
+  WT_CURSOR *cursor = GetCursor(table);
   std::vector<Field> current_values;
   WT_ITEM k = {key.data(), key.size()};
   WT_ITEM v;
   int ret;
 
-  cursor_->set_key(cursor_, &k);
-  ret = cursor_->search(cursor_);
+  cursor->set_key(cursor, &k);
+  ret = cursor->search(cursor);
   if(ret==WT_NOTFOUND){
     return kNotFound;
   } else if(ret != 0) {
     throw utils::Exception(WT_PREFIX " search error");
   }
-  error_check(cursor_->get_value(cursor_, &v));
-  DeserializeRow(&current_values, (const char*)v.data, v.size);
+  error_check(cursor->get_value(cursor, &v));
+  codec_.Decode(ItemView(v), &current_values);
   for (Field &new_field : values) {
     bool found MAYBE_UNUSED = false;
     for (Field &cur_field : current_values) {
@@ -280,11 +397,11 @@ DB::Status WTDB::UpdateSingleEntry(const std::string &table, const std::string &
   }
 
   std::string data;
-  SerializeRow(current_values, &data);
+  codec_.Encode(current_values, &data);
   v.data = data.data();
   v.size = data.size();
-  cursor_->set_value(cursor_, &v);
-  ret = cursor_->update(cursor_);
+  cursor->set_value(cursor, &v);
+  ret = cursor->update(cursor);
   if(ret==WT_NOTFOUND){
     return kNotFound;
   } else if(ret != 0) {
@@ -295,75 +412,59 @@ DB::Status WTDB::UpdateSingleEntry(const std::string &table, const std::string &
 
 DB::Status WTDB::InsertSingleEntry(const std::string &table, const std::string &key,
                            std::vector<Field> &values){
+  WT_CURSOR *cursor = GetCursor(table);
   std::string data;
   WT_ITEM k = {key.data(), key.size()}, v;
   
-  cursor_->set_key(cursor_, &k);
-  SerializeRow(values, &data);
+  cursor->set_key(cursor, &k);
+  codec_.Encode(values, &data);
   v.data = data.data();
   v.size = data.size();
-  cursor_->set_value(cursor_, &v);
-  error_check(cursor_->insert(cursor_));
+  cursor->set_value(cursor, &v);
+  error_check(cursor->insert(cursor));
   // TODO: cursor reset?
   return kOK;
 }
-DB::Status WTDB::DeleteSingleEntry(const std::string &table, const std::string &key){
-  WT_ITEM k = {key.data(), key.size()};
-  cursor_->set_key(cursor_, &k);
-  error_check(cursor_->remove(cursor_));
-  return kOK;
-}
-
-void WTDB::SerializeRow(const std::vector<Field> &values, std::string *data) {
-  for (const Field &field : values) {
-    uint32_t len = field.name.size();
-    data->append(reinterpret_cast<char *>(&len), sizeof(uint32_t)); // 4B
-    data->append(field.name.data(), field.name.size());             // len(name)
-    len = field.value.size();
-    data->append(reinterpret_cast<char *>(&len), sizeof(uint32_t)); // 4B
-    data->append(field.value.data(), field.value.size());           // len(value)
+// A bulk cursor builds the btree bottom-up from sorted input. It needs exclusive
+// access to the empty table, so this instance's own cursor is closed around it.
+DB::Status WTDB::BulkLoad(const std::string &table, RecordStream &records){
+  const std::string uri = TableUri(table, CoreWorkload::TableNames(*props_).size());
+  WT_CURSOR *cursor = GetCursor(table);
+  error_check(cursor->close(cursor));
+
+  WT_CURSOR *bulk;
+  error_check(session_->open_cursor(session_, uri.c_str(), NULL, "bulk", &bulk));
+  std::string key, data;
+  std::vector<Field> values;
+  while (records.Next(&key, &values)) {
+    WT_ITEM k = {key.data(), key.size()}, v;
+    data.clear();
+    codec_.Encode(values, &data);
+    v.data = data.data();
+    v.size = data.size();
+    bulk->set_key(bulk, &k);
+    bulk->set_value(bulk, &v);
+    error_check(bulk->insert(bulk));
   }
-}
+  error_check(bulk->close(bulk));
 
-void WTDB::DeserializeRow(std::vector<Field> *values, const char *data_ptr, size_t data_len) {
-  const char *p = data_ptr;
-  const char *lim = p + data_len;
-  while (p != lim) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    values->push_back({field, value});
+  WT_CURSOR *reopened;
+  error_check(session_->open_cursor(session_, uri.c_str(), NULL, "overwrite=true", &reopened));
+  if (cursor_ == cursor) {
+    cursor_ = reopened;
   }
-  assert(values->size() == fieldcount_);
+  if (!table_cursors_.empty()) {
+    table_cursors_[table] = reopened;
+  }
+  return kOK;
 }
 
-void WTDB::DeserializeRowFilter(std::vector<Field> *values, const char *data_ptr, size_t data_len,
-                                  const std::vector<std::string> &fields) {
-  const char *p = data_ptr;
-  const char *lim = p + data_len;
-  std::vector<std::string>::const_iterator filter_iter = fields.begin();
-  while (p != lim && filter_iter != fields.end()) {
-    assert(p < lim);
-    uint32_t len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string field(p, static_cast<const size_t>(len));
-    p += len;
-    len = *reinterpret_cast<const uint32_t *>(p);
-    p += sizeof(uint32_t);
-    std::string value(p, static_cast<const size_t>(len));
-    p += len;
-    if (*filter_iter == field) {
-      values->push_back({field, value});
-      filter_iter++;
-    }
-  }
-  assert(values->size() == fields.size());
+DB::Status WTDB::DeleteSingleEntry(const std::string &table, const std::string &key){
+  WT_CURSOR *cursor = GetCursor(table);
+  WT_ITEM k = {key.data(), key.size()};
+  cursor->set_key(cursor, &k);
+  error_check(cursor->remove(cursor));
+  return kOK;
 }
 
 DB *NewWTDB() {
@@ -372,4 +473,10 @@ DB *NewWTDB() {
 
 const bool registered = DBFactory::RegisterDB("wiredtiger", NewWTDB);
 
+static bool SingleEntryFormat(const utils::Properties &props) {
+  return props.GetProperty(PROP_FORMAT, PROP_FORMAT_DEFAULT) == "single";
+}
+
+const bool registered_static = RegisterStaticDB<WTDB::SingleEntry>("wiredtiger", SingleEntryFormat);
+
 }
\ No newline at end of file
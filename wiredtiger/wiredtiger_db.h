@@ -5,10 +5,13 @@
 #define _WIREDTIGER_DB_H
 
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <unordered_map>
 
 #include "core/db.h"
 #include "core/properties.h"
+#include "core/row_codec.h"
 
 #include "wiredtiger.h"
 #include "wiredtiger_ext.h"
@@ -24,6 +27,8 @@ class WTDB : public DB {
 
   void Cleanup();
 
+  class SingleEntry;
+
   Status Read(const std::string &table, const std::string &key,
               const std::vector<std::string> *fields, std::vector<Field> &result) {
     return (this->*(method_read_))(table, key, fields, result);
@@ -34,6 +39,21 @@ class WTDB : public DB {
     return (this->*(method_scan_))(table, key, len, fields, result);
   }
 
+  Status ScanVisit(std::string_view table, std::string_view key, int len,
+                   const std::vector<std::string> *fields, const ScanVisitor &visitor);
+
+  Status ReverseScan(const std::string &table, const std::string &key, int len,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    return (this->*(method_reverse_scan_))(table, key, len, fields, result);
+  }
+
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    return (this->*(method_range_scan_))(table, start_key, end_key, fields, result);
+  }
+
   Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
     return (this->*(method_update_))(table, key, values);
   }
@@ -46,28 +66,46 @@ class WTDB : public DB {
     return (this->*(method_delete_))(table, key);
   }
 
+  Status BulkLoad(const std::string &table, RecordStream &records);
+
  private:
+  // a WT_SESSION must only be used by one thread at a time
+  bool ThreadSafe() const { return false; }
 
   Status ReadSingleEntry(const std::string &table, const std::string &key,
                          const std::vector<std::string> *fields, std::vector<Field> &result);
   Status ScanSingleEntry(const std::string &table, const std::string &key, int len,
                          const std::vector<std::string> *fields,
                          std::vector<std::vector<Field>> &result);
+  Status ReverseScanSingleEntry(const std::string &table, const std::string &key, int len,
+                                const std::vector<std::string> *fields,
+                                std::vector<std::vector<Field>> &result);
+  Status RangeScanSingleEntry(const std::string &table, const std::string &start_key,
+                              const std::string &end_key, const std::vector<std::string> *fields,
+                              std::vector<std::vector<Field>> &result);
   Status UpdateSingleEntry(const std::string &table, const std::string &key,
                            std::vector<Field> &values);
   Status InsertSingleEntry(const std::string &table, const std::string &key,
                            std::vector<Field> &values);
   Status DeleteSingleEntry(const std::string &table, const std::string &key);
 
-  void SerializeRow(const std::vector<Field> &values, std::string *data);
-  void DeserializeRow(std::vector<Field> *values, const char *data_ptr, size_t data_len);
-  void DeserializeRowFilter(std::vector<Field> *values, const char *data_ptr, size_t data_len, const std::vector<std::string> &fields);
+  WT_CURSOR *GetCursor(const std::string &table) {
+    auto it = table_cursors_.find(table);
+    return it == table_cursors_.end() ? cursor_ : it->second;
+  }
+  static std::string TableUri(const std::string &table, size_t table_count);
 
   Status (WTDB::*method_read_)(const std::string &, const std:: string &,
                                     const std::vector<std::string> *, std::vector<Field> &);
   Status (WTDB::*method_scan_)(const std::string &, const std::string &, int,
                                     const std::vector<std::string> *,
                                     std::vector<std::vector<Field>> &);
+  Status (WTDB::*method_reverse_scan_)(const std::string &, const std::string &, int,
+                                       const std::vector<std::string> *,
+                                       std::vector<std::vector<Field>> &);
+  Status (WTDB::*method_range_scan_)(const std::string &, const std::string &,
+                                     const std::string &, const std::vector<std::string> *,
+                                     std::vector<std::vector<Field>> &);
   Status (WTDB::*method_update_)(const std::string &, const std::string &,
                                       std::vector<Field> &);
   Status (WTDB::*method_insert_)(const std::string &, const std::string &,
@@ -75,16 +113,59 @@ class WTDB : public DB {
   Status (WTDB::*method_delete_)(const std::string &, const std::string &);
   
   unsigned fieldcount_;
+  RowCodec codec_;
 
   static WT_CONNECTION *conn_;
   WT_SESSION *session_{nullptr};
   WT_CURSOR *cursor_{nullptr};
+  std::unordered_map<std::string, WT_CURSOR *> table_cursors_;
 
   static int ref_cnt_;
   static std::mutex mu_;
 
 };
 
+///
+/// WTDB compiled for wiredtiger.format=single: each call goes straight to the
+/// *SingleEntry method instead of through the method pointers chosen in Init.
+///
+class WTDB::SingleEntry final : public WTDB {
+ public:
+  Status Read(const std::string &table, const std::string &key,
+              const std::vector<std::string> *fields, std::vector<Field> &result) {
+    return ReadSingleEntry(table, key, fields, result);
+  }
+
+  Status Scan(const std::string &table, const std::string &key, int len,
+              const std::vector<std::string> *fields, std::vector<std::vector<Field>> &result) {
+    return ScanSingleEntry(table, key, len, fields, result);
+  }
+
+  Status ReverseScan(const std::string &table, const std::string &key, int len,
+                     const std::vector<std::string> *fields,
+                     std::vector<std::vector<Field>> &result) {
+    return ReverseScanSingleEntry(table, key, len, fields, result);
+  }
+
+  Status RangeScan(const std::string &table, const std::string &start_key,
+                   const std::string &end_key, const std::vector<std::string> *fields,
+                   std::vector<std::vector<Field>> &result) {
+    return RangeScanSingleEntry(table, start_key, end_key, fields, result);
+  }
+
+  Status Update(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    return UpdateSingleEntry(table, key, values);
+  }
+
+  Status Insert(const std::string &table, const std::string &key, std::vector<Field> &values) {
+    return InsertSingleEntry(table, key, values);
+  }
+
+  Status Delete(const std::string &table, const std::string &key) {
+    return DeleteSingleEntry(table, key);
+  }
+};
+
 DB *NewRocksdbDB();
 
 } // namespace ycsbc